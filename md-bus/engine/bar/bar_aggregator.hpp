@@ -0,0 +1,244 @@
+#pragma once
+#include <unordered_map>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../common/event.hpp"
+#include "../common/event_io.hpp"
+#include "../common/log.hpp"
+
+namespace md {
+
+// One bar size and the topic its bars are published on.
+struct BarTimeframe {
+    uint64_t bucket_ns;
+    Topic topic;
+};
+
+/*
+ * BarAggregator
+ * -------------
+ * The OHLCV bucketing behind BarBuilder, without a bus: feed it ticks in
+ * time order and it hands each bar to emit(const Bar&, Topic) as its
+ * bucket closes. BarBuilder publishes those bars; BacktestDriver
+ * dispatches them straight to the strategies.
+ *
+ * The first timeframe is built from ticks. Others (add_timeframe, all
+ * multiples of the first) are rolled up from bars: each from the largest
+ * smaller timeframe that divides it, so 1s bars fold into 1m bars and 1m
+ * bars into 5m bars, and a tick touches one symbol's state once however
+ * many timeframes there are.
+ *
+ * A bar closes when the first tick of a later bucket arrives for its
+ * symbol (end_ts_ns is then the last nanosecond of the bucket), or on
+ * flush() (end_ts_ns is the last tick seen). Bars that close together are
+ * emitted smallest timeframe first.
+ *
+ * on_tick_id() is the same for sources that already carry dense symbol ids
+ * (ColumnDataset, ids in first-seen order): state is found by index
+ * instead of by hashing the name. Feed one aggregator through one of the
+ * two, not both.
+ */
+class BarAggregator {
+private :
+    //carries the information about
+    //active, bucket_id, bar
+    struct BarState {
+        bool active {false};
+        uint64_t bucket_id{0};
+        Bar bar;
+    };
+
+    std::vector<BarTimeframe> tfs_;
+    std::vector<std::size_t> source_;   // per timeframe: the one it rolls up from
+    std::unordered_map<std::string, uint32_t> ids_;   // on_tick: first-seen order
+    std::vector<BarState> by_id_;       // [id * timeframes + k]
+    std::vector<uint8_t> closed_;       // roll_up: per timeframe, closed this step
+
+    static constexpr uint64_t kFlushing = UINT64_MAX;
+
+    void open_bar(BarState& st, const std::string& symbol, double pq, uint32_t qty,
+                  uint64_t bucket_id, uint64_t ts) {
+        st.active = true;
+        st.bucket_id = bucket_id;
+        st.bar.symbol = symbol;
+        st.bar.open = pq;
+        st.bar.high = pq;
+        st.bar.low = pq;
+        st.bar.close = pq;
+        st.bar.volume = qty;
+        st.bar.start_ts_ns = bucket_id * tfs_[0].bucket_ns;
+        st.bar.end_ts_ns = ts;
+    }
+
+    // After a base bar has closed: folds each closed bar into the
+    // timeframes rolled up from it, closing those whose bucket ends before
+    // next_ts (all of them when flushing). Ascending k, so bars that close
+    // together are emitted smallest timeframe first.
+    template <typename F>
+    void roll_up(BarState* sym, uint64_t next_ts, F& emit) {
+        closed_[0] = 1;
+        for(std::size_t k = 1; k < tfs_.size(); ++k) {
+            closed_[k] = 0;
+            if(!closed_[source_[k]]) continue;
+            const Bar& b = sym[source_[k]].bar;
+            const uint64_t ns = tfs_[k].bucket_ns;
+            BarState& st = sym[k];
+            if(!st.active) {
+                st.active = true;
+                st.bucket_id = b.start_ts_ns / ns;
+                st.bar = b;
+                st.bar.start_ts_ns = st.bucket_id * ns;
+            } else {
+                if(b.high > st.bar.high) st.bar.high = b.high;
+                if(b.low < st.bar.low) st.bar.low = b.low;
+                st.bar.close = b.close;
+                st.bar.volume += b.volume;
+                st.bar.end_ts_ns = b.end_ts_ns;
+            }
+            if(next_ts != kFlushing && next_ts / ns == st.bucket_id) continue;
+            if(next_ts != kFlushing) st.bar.end_ts_ns = (st.bucket_id + 1) * ns - 1;
+            st.active = false;
+            closed_[k] = 1;
+            emit(static_cast<const Bar&>(st.bar), tfs_[k].topic);
+        }
+    }
+public :
+    static constexpr uint64_t NS_PER_SEC = 1'000'000'000ULL;
+    static constexpr uint64_t NS_PER_MIN = 60 * NS_PER_SEC;
+
+    // 1s, 1m and 5m bars on BAR_1S, BAR_1M and BAR_5M.
+    static std::vector<BarTimeframe> standard_timeframes() {
+        return {{NS_PER_SEC, Topic::BAR_1S}, {NS_PER_MIN, Topic::BAR_1M}, {5 * NS_PER_MIN, Topic::BAR_5M}};
+    }
+
+    explicit BarAggregator(uint64_t bucket_ns = NS_PER_SEC, Topic topic = Topic::BAR_1S)
+        : tfs_{{bucket_ns, topic}}, source_{0}, closed_(1) {}
+
+    // The first timeframe is built from ticks, the rest rolled up from it.
+    explicit BarAggregator(const std::vector<BarTimeframe>& timeframes)
+        : BarAggregator(timeframes.empty() ? NS_PER_SEC : timeframes[0].bucket_ns,
+                        timeframes.empty() ? Topic::BAR_1S : timeframes[0].topic) {
+        for(std::size_t k = 1; k < timeframes.size(); ++k) add_timeframe(timeframes[k]);
+    }
+
+    uint64_t bucket_ns() const { return tfs_[0].bucket_ns; }
+    const std::vector<BarTimeframe>& timeframes() const { return tfs_; }
+
+    // Adds a rolled-up timeframe. False (and ignored) unless it is a
+    // multiple of the first, its size and topic are not already in use,
+    // and no tick has been seen yet. A Bar does not carry its size, so the
+    // topic is what tells timeframes apart downstream.
+    bool add_timeframe(BarTimeframe tf) {
+        const uint64_t base = tfs_[0].bucket_ns;
+        if(!by_id_.empty() || tf.bucket_ns <= base || tf.bucket_ns % base != 0) {
+            log_warn("BarAggregator: cannot roll {} ns bars up from {} ns bars", tf.bucket_ns, base);
+            return false;
+        }
+        for(const auto& have : tfs_) {
+            if(have.topic == tf.topic && have.bucket_ns != tf.bucket_ns) {
+                log_warn("BarAggregator: topic {} already carries {} ns bars, not adding {} ns",
+                         to_string(tf.topic), have.bucket_ns, tf.bucket_ns);
+                return false;
+            }
+        }
+        std::size_t at = 1;
+        for(; at < tfs_.size() && tfs_[at].bucket_ns < tf.bucket_ns; ++at) {}
+        if(at < tfs_.size() && tfs_[at].bucket_ns == tf.bucket_ns) {
+            log_warn("BarAggregator: timeframe {} ns given twice", tf.bucket_ns);
+            return false;
+        }
+        tfs_.insert(tfs_.begin() + static_cast<std::ptrdiff_t>(at), tf);
+        closed_.resize(tfs_.size());
+        // each timeframe rolls up from the largest smaller one dividing it
+        source_.assign(tfs_.size(), 0);
+        for(std::size_t k = 1; k < tfs_.size(); ++k) {
+            for(std::size_t j = k - 1; j > 0; --j) {
+                if(tfs_[k].bucket_ns % tfs_[j].bucket_ns == 0) {
+                    source_[k] = j;
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Adds a tick stamped ts; emit(const Bar&, Topic) gets every bar it
+    // closes.
+    template <typename F>
+    void on_tick(const Tick& t, uint64_t ts, F&& emit) {
+        if(ts == 0) {
+            return;
+        }
+        const auto id = ids_.try_emplace(t.symbol, static_cast<uint32_t>(ids_.size())).first->second;
+        on_tick_id(id, t.symbol, t.pq, t.qty, ts, emit);
+    }
+
+    // As on_tick, for the symbol with dense id `id` (named symbol).
+    template <typename F>
+    void on_tick_id(uint32_t id, const std::string& symbol, double pq, uint32_t qty,
+                    uint64_t ts, F&& emit) {
+        if(ts == 0) {
+            return;
+        }
+        const std::size_t n = tfs_.size();
+        if((std::size_t{id} + 1) * n > by_id_.size()) by_id_.resize((std::size_t{id} + 1) * n);
+        BarState* sym = &by_id_[std::size_t{id} * n];
+        BarState& st = sym[0];
+
+        //gives you a monotonic bucket number:
+        //All timestamps in [0, bucket_ns) → bucket 0
+        //bucket_ns, 2*bucket_ns) → bucket 1
+        //2*bucket_ns, 3*bucket_ns) → bucket 2
+        const uint64_t bucket_ns = tfs_[0].bucket_ns;
+        const uint64_t bucket_id = ts / bucket_ns;
+
+        if(!st.active) {
+            open_bar(st, symbol, pq, qty, bucket_id, ts);
+            return;
+        }
+
+        // If this tick belongs to a new bucket, finalize the old bar and start a new one
+        if(bucket_id != st.bucket_id) {
+            //example : bucket = 12 →
+            //end = (12+1)*1s - 1 = 12.999999999s
+            st.bar.end_ts_ns = (st.bucket_id + 1) * bucket_ns - 1;
+            emit(static_cast<const Bar&>(st.bar), tfs_[0].topic);
+            if(n > 1) roll_up(sym, ts, emit);
+            open_bar(st, symbol, pq, qty, bucket_id, ts);
+            return;
+        }
+        if(pq > st.bar.high) st.bar.high = pq;
+        if (pq < st.bar.low)  st.bar.low  = pq;
+        st.bar.close  = pq;
+        st.bar.volume += qty;
+        st.bar.end_ts_ns = ts;
+    }
+
+    // Emits every open bar, in order of the symbols' first ticks (and per
+    // symbol smallest timeframe first), and closes it.
+    template <typename F>
+    void flush(F&& emit) {
+        const std::size_t n = tfs_.size();
+        for(std::size_t at = 0; at < by_id_.size(); at += n) {
+            BarState& st = by_id_[at];
+            if(!st.active) continue;
+            st.active = false;
+            emit(static_cast<const Bar&>(st.bar), tfs_[0].topic);
+            if(n > 1) roll_up(&by_id_[at], kFlushing, emit);
+        }
+    }
+
+    // The event BarBuilder publishes for b.
+    static Event bar_event(const Bar& b, Topic topic = Topic::BAR_1S) {
+        Event ev;
+        ev.h.seq = 0;
+        ev.h.ts_ns = b.end_ts_ns;
+        ev.h.topic = topic;
+        ev.p = b;
+        return ev;
+    }
+};
+
+}
@@ -1,7 +1,9 @@
 #include "../bus/bus.hpp"
 #include "../common/event.hpp"
 #include "../common/log.hpp"
+#include "../common/trace.hpp"
 #include <fmt/core.h>
+#include <algorithm>
 
 
 //this is the feature implementation file for bus.hpp
@@ -26,26 +28,32 @@ EventBus::~EventBus() { stop(); }
 //the main thread return from the call while the worker thread continues 
 //to call the callback function on the things published 
 //the joining to the main thread happens in unsubscribe portion
-SubId EventBus::subscribe(Topic T, Callback cb){
+SubId EventBus::subscribe(Topic T, Callback cb, std::string name){
     auto id = next_id_.fetch_add(1, std::memory_order_relaxed);
     auto slot = std::make_unique<SubSlot>();
     slot->t = T;
     slot->q = std::make_unique<BoundedQueue<Event>>(per_sub_cap_);
     slot->cb = std::move(cb);
-    slot->worker = std::thread([s = slot.get()]{ // s is a lamda capture with c++14 and up (lamda local variable)
+    slot->name = name.empty() ? "sub-" + std::to_string(id) : std::move(name);
+    slot->worker = std::thread([this, s = slot.get()]{ // s is a lamda capture with c++14 and up (lamda local variable)
     // .get() returns a SubSlot* raw pointer
+    MD_TRACE_THREAD_NAME(s->name);
     Event ev;
     while (s->run.load(std::memory_order_relaxed)) {
       if (s->q->pop(ev)) {
-        s->cb(ev); // execute user callback(that was passed during subscribe)
+        run_callback(*s, ev); // execute user callback(that was passed during subscribe)
       }
     }
     // optional: drain remaining events before exit
     while (s->q->size() > 0) {
       s->q->pop(ev);
-      s->cb(ev);
+      run_callback(*s, ev);
     }
   });
+    {
+        std::scoped_lock lk(watch_mu_);
+        watch_.emplace(id, slot.get());
+    }
     {
         std::scoped_lock lk(mu_);
         subs_.emplace(id, std::move(slot));
@@ -53,24 +61,31 @@ SubId EventBus::subscribe(Topic T, Callback cb){
     return id;
 }
 
-SubId EventBus::subscribe_all(Callback cb){
+SubId EventBus::subscribe_all(Callback cb, std::string name){
     auto id = next_id_.fetch_add(1, std::memory_order_relaxed);
     auto slot = std::make_unique<SubSlot>();
     slot->t = Topic::MD_TICK; // irrelevant all msg will be sent
+    slot->all = true;
     slot->q = std::make_unique<BoundedQueue<Event>>(per_sub_cap_);
     slot->cb = std::move(cb); // remember to move
-    slot->worker = std::thread([s = slot.get()]{
+    slot->name = name.empty() ? "sub-all-" + std::to_string(id) : std::move(name);
+    slot->worker = std::thread([this, s = slot.get()]{
+        MD_TRACE_THREAD_NAME(s->name);
         Event ev;
         while(s->run.load(std::memory_order_relaxed)){
             if(s->q->pop(ev)){
-                s->cb(ev);
+                run_callback(*s, ev);
             }
         }
         while(s->q->size() > 0){
             s->q->pop(ev);
-            s->cb(ev);
+            run_callback(*s, ev);
         }
     });
+    {
+        std::scoped_lock lk(watch_mu_);
+        watch_.emplace(id, slot.get());
+    }
     {
         std::scoped_lock lk(mu_);
         all_subs_.emplace(id, std::move(slot));
@@ -78,6 +93,33 @@ SubId EventBus::subscribe_all(Callback cb){
     return id;
 }
 
+// Runs the user callback, timing it for the per-subscription histogram
+void EventBus::run_callback(SubSlot& s, const Event& ev){
+    MD_TRACE_SCOPE("callback", "bus", ev.h.seq);
+    const uint64_t t0 = now_ns();
+    s.cb(ev);
+    const uint64_t t1 = now_ns();
+    const uint64_t dt = t1 - t0;
+    s.cb_ns.record(dt);
+
+    const uint64_t thr = slow_cb_threshold_ns_.load(std::memory_order_relaxed);
+    if(thr == 0 || dt < thr) return;
+    s.slow_calls.fetch_add(1, std::memory_order_relaxed);
+
+    static constexpr uint64_t kWarnEveryNs = 1'000'000'000ULL;
+    if(s.last_slow_warn_ns != 0 && t1 - s.last_slow_warn_ns < kWarnEveryNs) return;
+    s.last_slow_warn_ns = t1;
+
+    const std::size_t qsize = s.q->size();
+    log_warn("EventBus: slow callback sub='{}' took {}us (threshold {}us, queue={})",
+             s.name, dt / 1000, thr / 1000, qsize);
+
+    Header h{};
+    h.topic = Topic::LOG;
+    try_publish(Event{h, fmt::format("SLOW_CALLBACK sub={} dur_ns={} queue={}",
+                                     s.name, dt, qsize)});
+}
+
 //join back from the information stored in SubSlot
 //first check joinable(fanning out the left over Event in the subqueue)
 void EventBus::unsubscribe(SubId id){
@@ -95,6 +137,10 @@ void EventBus::unsubscribe(SubId id){
             all_subs_.erase(it2);
         }
     }
+    {
+        std::scoped_lock lk(watch_mu_);
+        watch_.erase(id);
+    }
     s->run.store(false, std::memory_order_relaxed);
     s->q->push(Event{}); // this can trigger the pop to wake up the worker if it's waiting
     //but this will run the callback with an empty Event
@@ -105,6 +151,7 @@ void EventBus::unsubscribe(SubId id){
 bool EventBus::publish(Event e){
     e.h.seq = seq_.fetch_add(1, std::memory_order_relaxed);
     e.h.ts_ns = now_ns();
+    MD_TRACE_SCOPE("publish", "bus", e.h.seq);
 
     published_.fetch_add(1, std::memory_order_relaxed);
 
@@ -118,16 +165,27 @@ bool EventBus::publish_preserve(Event e){
     if (e.h.ts_ns == 0) {
         e.h.ts_ns = now_ns();
     }
+    MD_TRACE_SCOPE("publish", "bus", e.h.seq);
 
     published_.fetch_add(1, std::memory_order_relaxed);
     return ingress_->push(std::move(e));
 }
 
+bool EventBus::try_publish(Event e){
+    e.h.seq = seq_.fetch_add(1, std::memory_order_relaxed);
+    e.h.ts_ns = now_ns();
+    if(!ingress_->try_push(std::move(e))) return false;
+    published_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
 // Routes Events to Subscribers with matching topic
 void EventBus::reactor_loop() {
+    MD_TRACE_THREAD_NAME("bus-reactor");
     Event ev;
     while(run_.load(std::memory_order_relaxed)){
         if(!ingress_->pop(ev)) continue;
+        MD_TRACE_SCOPE("route", "bus", ev.h.seq);
         
         ingress_popped_.fetch_add(1, std::memory_order_relaxed);
         if(ev.h.ts_ns != 0){
@@ -138,7 +196,7 @@ void EventBus::reactor_loop() {
         }
 
 #ifdef BUS_DEBUG
-        log_debug("[REACTOR] seq = {} topic = {}",
+        MD_LOG_DEBUG("[REACTOR] seq = {} topic = {}",
         ev.h.seq,
         static_cast<int>(ev.h.topic));
 #endif
@@ -164,7 +222,7 @@ void EventBus::reactor_loop() {
             }
         }
 #ifdef BUS_DEBUG
-        log_debug("[REACTOR-DRAIN] seq={} topic={}",
+        MD_LOG_DEBUG("[REACTOR-DRAIN] seq={} topic={}",
                    ev.h.seq,
                    static_cast<int>(ev.h.topic));
 #endif
@@ -187,6 +245,7 @@ void EventBus::reactor_loop() {
 
 void EventBus::stop(){
     if(!run_.exchange(false))return;
+    stop_watchdog();
     ingress_->push(Event{}); // wake up reactor if waiting 
     //because pop is blocking in reactor if nothing comes in ingress queue 
     //then it will stay blocked forever
@@ -220,6 +279,95 @@ void EventBus::print_stats() const {
     log_info("  topic[LOG]       = {}", load_topic(Topic::LOG));
     log_info("  topic[HEARTBEAT] = {}", load_topic(Topic::HEARTBEAT));
     log_info("  topic[BAR_1S]    = {}", load_topic(Topic::BAR_1S));
+    log_info("  topic[BAR_1M]    = {}", load_topic(Topic::BAR_1M));
+    log_info("  topic[BAR_5M]    = {}", load_topic(Topic::BAR_5M));
+    log_info("  topic[BAR_CUSTOM]= {}", load_topic(Topic::BAR_CUSTOM));
 }
 
-}
\ No newline at end of file
+void EventBus::set_slow_callback_threshold(std::chrono::nanoseconds threshold){
+    auto ns = threshold.count() > 0 ? static_cast<uint64_t>(threshold.count()) : 0;
+    slow_cb_threshold_ns_.store(ns, std::memory_order_relaxed);
+    log_info("EventBus: slow callback threshold = {}us", ns / 1000);
+}
+
+void EventBus::start_watchdog(Duration period, int growth_samples){
+    if(watchdog_) return;
+    watchdog_growth_samples_ = growth_samples > 0 ? growth_samples : 1;
+    watchdog_ = std::make_unique<SimpleTimer>(period, [this]{ watchdog_tick(); });
+    watchdog_->start();
+    log_info("EventBus: watchdog started (period = {}ms, growth_samples = {})",
+             period.count(), watchdog_growth_samples_);
+}
+
+void EventBus::stop_watchdog(){
+    if(!watchdog_) return;
+    watchdog_->stop();
+    watchdog_.reset();
+}
+
+// A queue that keeps growing (or sits at capacity, which means the reactor
+// is blocked on it) for N consecutive samples belongs to a consumer that
+// cannot keep up. Reported again every N samples while it persists.
+void EventBus::watchdog_tick(){
+    std::vector<std::string> warnings;
+    {
+        std::scoped_lock lk(watch_mu_);
+        for(auto &kv : watch_){
+            SubSlot& s = *kv.second;
+            const std::size_t qsize = s.q->size();
+            const bool growing = qsize > 0 &&
+                                 (qsize > s.last_q_size || qsize >= per_sub_cap_);
+            s.growth_streak = growing ? s.growth_streak + 1 : 0;
+            s.last_q_size = qsize;
+
+            if(s.growth_streak > 0 && s.growth_streak % watchdog_growth_samples_ == 0){
+                warnings.push_back(fmt::format(
+                    "SLOW_CONSUMER sub={} queue={}/{} samples={} cb_p99_ns={}",
+                    s.name, qsize, per_sub_cap_, s.growth_streak, s.cb_ns.percentile(0.99)));
+            }
+        }
+    }
+    for(auto &msg : warnings){
+        log_warn("EventBus watchdog: {}", msg);
+        Header h{};
+        h.topic = Topic::LOG;
+        try_publish(Event{h, std::move(msg)});
+    }
+}
+
+std::vector<SubStats> EventBus::sub_stats() const {
+    std::vector<SubStats> out;
+    std::scoped_lock lk(watch_mu_);
+    out.reserve(watch_.size());
+    for(const auto &kv : watch_){
+        const SubSlot& s = *kv.second;
+        SubStats st;
+        st.id = kv.first;
+        st.name = s.name;
+        st.all_topics = s.all;
+        st.topic = s.t;
+        st.queue_size = s.q->size();
+        st.calls = s.cb_ns.count();
+        st.mean_ns = s.cb_ns.mean();
+        st.p50_ns = s.cb_ns.percentile(0.50);
+        st.p99_ns = s.cb_ns.percentile(0.99);
+        st.max_ns = s.cb_ns.max();
+        st.slow_calls = s.slow_calls.load(std::memory_order_relaxed);
+        out.push_back(std::move(st));
+    }
+    std::sort(out.begin(), out.end(), [](const SubStats& a, const SubStats& b){
+        return a.id < b.id;
+    });
+    return out;
+}
+
+void EventBus::print_sub_stats() const {
+    log_info("EventBus subscription stats:");
+    for(const auto &st : sub_stats()){
+        log_info("  [{}] {:<28} calls={} queue={} mean={}ns p50={}ns p99={}ns max={}ns slow={}",
+                 st.id, st.name, st.calls, st.queue_size,
+                 st.mean_ns, st.p50_ns, st.p99_ns, st.max_ns, st.slow_calls);
+    }
+}
+
+}
@@ -1,5 +1,7 @@
 #pragma once
+#include<array>
 #include<atomic>
+#include<chrono>
 #include<functional>
 #include<memory>
 #include<string>
@@ -9,12 +11,29 @@
 
 #include "../common/bounded_queue.hpp"
 #include "../common/event.hpp"
+#include "../common/latency_histogram.hpp"
+#include "../io/timer.hpp"
 
 namespace md {
 
 using Callback = std::function<void(const Event&)>;
 using SubId = uint64_t;
 
+// Snapshot of one subscription's health (see EventBus::sub_stats)
+struct SubStats {
+    SubId id{0};
+    std::string name;
+    bool all_topics{false};
+    Topic topic{Topic::MD_TICK};
+    std::size_t queue_size{0};
+    uint64_t calls{0};
+    uint64_t mean_ns{0};
+    uint64_t p50_ns{0};
+    uint64_t p99_ns{0};
+    uint64_t max_ns{0};
+    uint64_t slow_calls{0};
+};
+
 class EventBus {
 private:
     struct SubSlot {
@@ -23,18 +42,36 @@ private:
         std::thread worker;
         std::atomic<bool>run{true};
         Callback cb;
+        std::string name;
+        bool all{false};
+
+        // callback profiling (written by the worker, read by anyone)
+        LatencyHistogram cb_ns;
+        std::atomic<uint64_t> slow_calls{0};
+        uint64_t last_slow_warn_ns{0}; // worker only
+
+        // watchdog bookkeeping (guarded by watch_mu_)
+        std::size_t last_q_size{0};
+        int growth_streak{0};
     };
 
     void reactor_loop();
+    void run_callback(SubSlot& s, const Event& ev);
+    void watchdog_tick();
+    bool try_publish(Event e); // never blocks; used for bus-generated warnings
 
     std::unique_ptr<BoundedQueue<Event>> ingress_; //producer - > reactor
     std::thread reactor_;
     std::atomic<bool> run_{true};
 
     // rounting and bookkeeping (for subscriptions)
-    std::mutex mu_;
+    mutable std::mutex mu_;
     std::unordered_map<SubId, std::unique_ptr<SubSlot>> subs_;
     std::unordered_map<SubId, std::unique_ptr<SubSlot>> all_subs_;
+    // second view of the live slots for the watchdog / stats; the reactor can
+    // sit in a blocking push while holding mu_, exactly when we need to look
+    mutable std::mutex watch_mu_;
+    std::unordered_map<SubId, SubSlot*> watch_;
     const size_t per_sub_cap_;
 
     // sequence + ids
@@ -48,14 +85,20 @@ private:
     std::array<std::atomic<uint64_t>, kMaxTopics> topic_counts_{0}; // array to keep 
     //track of the topic counts
 
+    // slow consumer detection
+    std::atomic<uint64_t> slow_cb_threshold_ns_{0}; // 0 = off
+    int watchdog_growth_samples_{3};
+    std::unique_ptr<SimpleTimer> watchdog_;
+
 public:
     explicit EventBus(size_t ingress_cap = 65536, size_t per_sub_cap = 65536);
 
     ~EventBus();
 
     //declaration
-    SubId subscribe(Topic T, Callback cb);
-    SubId subscribe_all(Callback cb);
+    //name identifies the subscriber in stats and slow-consumer warnings
+    SubId subscribe(Topic T, Callback cb, std::string name = {});
+    SubId subscribe_all(Callback cb, std::string name = {});
     void unsubscribe(SubId id);
 
     // (non blocking) enqueue in ingress_ and return
@@ -65,6 +108,18 @@ public:
 
     void print_stats() const;
 
+    // Callbacks running longer than threshold are counted and reported with
+    // a warning (log + LOG event, at most once per second per subscription).
+    // A zero threshold turns the check off.
+    void set_slow_callback_threshold(std::chrono::nanoseconds threshold);
+
+    // Samples every subscription queue each period; a queue that grew for
+    // growth_samples consecutive samples is reported as a slow consumer.
+    void start_watchdog(Duration period = Duration(500), int growth_samples = 3);
+    void stop_watchdog();
+
+    std::vector<SubStats> sub_stats() const;
+    void print_sub_stats() const;
 
 
 };
@@ -0,0 +1,269 @@
+#include "async_log.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "log.hpp"
+
+namespace md {
+
+namespace {
+
+// Single producer (the owning thread) / single consumer (logger thread)
+// byte ring. head/tail are monotonically increasing byte counters.
+struct LogRing {
+    std::vector<char> buf;
+    std::size_t mask{0};
+    unsigned long long tid_hash{0};
+
+    alignas(64) std::atomic<uint64_t> head{0};
+    uint64_t cached_tail{0};   // producer's last view of tail
+    uint64_t pending{0};       // bytes claimed by the last reserve
+
+    alignas(64) std::atomic<uint64_t> tail{0};
+    std::atomic<bool> owner_alive{true};
+
+    explicit LogRing(std::size_t bytes) {
+        std::size_t cap = 4096;
+        while(cap < bytes) cap <<= 1;
+        buf.resize(cap);
+        mask = cap - 1;
+    }
+};
+
+struct Logger {
+    std::mutex mu;
+    std::condition_variable cv;
+    std::vector<std::shared_ptr<LogRing>> rings;
+    AsyncLogConfig cfg;
+    std::thread worker;
+    bool stopping{false};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> generation{1};
+
+    // logger-thread scratch, reused across batches
+    struct Line {
+        uint64_t ts_ns;
+        std::size_t off;
+        std::size_t len;
+    };
+    fmt::memory_buffer text;
+    fmt::memory_buffer msg;
+    std::vector<Line> lines;
+    std::string out;
+};
+
+// leaked on purpose: producer thread_locals and the exit hook may touch it
+// after other statics are gone
+Logger& logger() {
+    static Logger* l = new Logger;
+    return *l;
+}
+
+struct LocalRing {
+    std::shared_ptr<LogRing> ring;
+    uint64_t generation{0};
+    ~LocalRing() {
+        if(ring) ring->owner_alive.store(false, std::memory_order_release);
+    }
+};
+
+LocalRing& local_ring() {
+    thread_local LocalRing lr;
+    return lr;
+}
+
+LogRing& ring_for_this_thread() {
+    auto& lr = local_ring();
+    auto& lg = logger();
+    const uint64_t gen = lg.generation.load(std::memory_order_acquire);
+    if(!lr.ring || lr.generation != gen) {
+        auto r = std::make_shared<LogRing>(lg.cfg.ring_bytes);
+        r->tid_hash = static_cast<unsigned long long>(
+            std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        {
+            std::scoped_lock lk(lg.mu);
+            lg.rings.push_back(r);
+        }
+        if(lr.ring) lr.ring->owner_alive.store(false, std::memory_order_release);
+        lr.ring = std::move(r);
+        lr.generation = gen;
+    }
+    return *lr.ring;
+}
+
+constexpr int32_t kPadLevel = -1;
+
+// Formats everything currently committed in r into lg.text / lg.lines.
+void drain_ring(Logger& lg, LogRing& r) {
+    uint64_t t = r.tail.load(std::memory_order_relaxed);
+    const uint64_t h = r.head.load(std::memory_order_acquire);
+    while(t < h) {
+        const char* p = r.buf.data() + (t & r.mask);
+        uint32_t size;
+        int32_t level;
+        std::memcpy(&size, p, sizeof(size));
+        std::memcpy(&level, p + sizeof(size), sizeof(level));
+        if(level != kPadLevel) {
+            detail::LogRecordHeader hdr;
+            std::memcpy(&hdr, p, sizeof(hdr));
+
+            lg.msg.clear();
+            hdr.decode(std::string_view(hdr.fmt, hdr.fmt_len), p + sizeof(hdr), lg.msg);
+
+            const std::size_t off = lg.text.size();
+            fmt::format_to(std::back_inserter(lg.text), "[{}] t = {}ms tid = {} ",
+                           to_string(static_cast<LogLevel>(hdr.level)),
+                           hdr.ts_ns / 1'000'000ULL, r.tid_hash);
+            lg.text.append(lg.msg.data(), lg.msg.data() + lg.msg.size());
+            lg.text.push_back('\n');
+            lg.lines.push_back({hdr.ts_ns, off, lg.text.size() - off});
+        }
+        t += size;
+    }
+    r.tail.store(t, std::memory_order_release);
+}
+
+// One logger pass over every ring. Returns the number of lines written.
+std::size_t flush_once(Logger& lg) {
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+        std::scoped_lock lk(lg.mu);
+        rings = lg.rings;
+    }
+
+    lg.text.clear();
+    lg.lines.clear();
+    for(auto& r : rings) drain_ring(lg, *r);
+
+    if(!lg.lines.empty()) {
+        // interleave the threads by timestamp; each ring is already in order
+        std::stable_sort(lg.lines.begin(), lg.lines.end(),
+                         [](const Logger::Line& a, const Logger::Line& b) {
+                             return a.ts_ns < b.ts_ns;
+                         });
+        lg.out.clear();
+        lg.out.reserve(lg.text.size());
+        for(const auto& ln : lg.lines) lg.out.append(lg.text.data() + ln.off, ln.len);
+
+        std::scoped_lock lk(log_mutex());
+        std::fwrite(lg.out.data(), 1, lg.out.size(), lg.cfg.out);
+        std::fflush(lg.cfg.out);
+    }
+
+    // forget rings whose thread has exited and that are fully drained
+    {
+        std::scoped_lock lk(lg.mu);
+        lg.rings.erase(std::remove_if(lg.rings.begin(), lg.rings.end(),
+            [](const std::shared_ptr<LogRing>& r) {
+                return !r->owner_alive.load(std::memory_order_acquire) &&
+                       r->tail.load(std::memory_order_relaxed) ==
+                       r->head.load(std::memory_order_acquire);
+            }), lg.rings.end());
+    }
+    return lg.lines.size();
+}
+
+struct ExitHook {
+    ~ExitHook() { stop_async_logging(); }
+};
+ExitHook exit_hook;
+
+}
+
+namespace detail {
+
+char* log_ring_reserve(std::size_t len) {
+    LogRing& r = ring_for_this_thread();
+    const std::size_t cap = r.buf.size();
+    len = (len + 7) & ~static_cast<std::size_t>(7);
+
+    const uint64_t h = r.head.load(std::memory_order_relaxed);
+    const std::size_t pos = static_cast<std::size_t>(h & r.mask);
+    const std::size_t contiguous = cap - pos;
+    const std::size_t need = len <= contiguous ? len : contiguous + len;
+
+    if(len > cap / 2) {
+        logger().dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if(h + need - r.cached_tail > cap) {
+        r.cached_tail = r.tail.load(std::memory_order_acquire);
+        if(h + need - r.cached_tail > cap) {
+            logger().dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+
+    char* p = r.buf.data() + pos;
+    if(need != len) {
+        // not enough room before the end: pad it out and wrap to the start
+        const auto pad = static_cast<uint32_t>(contiguous);
+        std::memcpy(p, &pad, sizeof(pad));
+        std::memcpy(p + sizeof(pad), &kPadLevel, sizeof(kPadLevel));
+        p = r.buf.data();
+    }
+    const auto size = static_cast<uint32_t>(len);
+    std::memcpy(p, &size, sizeof(size));
+    r.pending = need;
+    return p;
+}
+
+void log_ring_commit() {
+    LogRing& r = *local_ring().ring;
+    r.head.store(r.head.load(std::memory_order_relaxed) + r.pending,
+                 std::memory_order_release);
+}
+
+}
+
+void start_async_logging(const AsyncLogConfig& cfg) {
+    auto& lg = logger();
+    {
+        std::scoped_lock lk(lg.mu);
+        if(lg.worker.joinable()) return;
+        lg.cfg = cfg;
+        lg.stopping = false;
+        lg.rings.clear();
+        lg.generation.fetch_add(1, std::memory_order_release);
+        lg.worker = std::thread([&lg] {
+            std::unique_lock lk(lg.mu);
+            while(!lg.stopping) {
+                lg.cv.wait_for(lk, lg.cfg.flush_interval);
+                lk.unlock();
+                flush_once(lg);
+                lk.lock();
+            }
+        });
+    }
+    detail::async_log_flag().store(true, std::memory_order_release);
+}
+
+void stop_async_logging() {
+    auto& lg = logger();
+    if(!detail::async_log_flag().exchange(false)) return;
+    {
+        std::scoped_lock lk(lg.mu);
+        lg.stopping = true;
+    }
+    lg.cv.notify_all();
+    if(lg.worker.joinable()) lg.worker.join();
+
+    // anything committed after the worker's last pass
+    flush_once(lg);
+    const uint64_t dropped = lg.dropped.load(std::memory_order_relaxed);
+    if(dropped > 0) {
+        log_warn("async logger: dropped {} records (ring full)", dropped);
+    }
+}
+
+uint64_t async_log_dropped() {
+    return logger().dropped.load(std::memory_order_relaxed);
+}
+
+}
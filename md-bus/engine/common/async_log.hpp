@@ -0,0 +1,173 @@
+#pragma once
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+/*
+ * Asynchronous logger back end for md::log
+ * ----------------------------------------
+ * Once start_async_logging() is called, every md::log call on the hot path
+ * only copies the format string pointer plus its arguments into the calling
+ * thread's lock-free SPSC ring and returns. A background thread drains all
+ * rings every flush_interval, formats the records, orders them by time and
+ * writes the batch with a single fwrite.
+ *
+ * Argument capture:
+ *   - arithmetic values are copied as-is
+ *   - anything convertible to std::string_view (std::string, const char*,
+ *     literals) is copied as bytes
+ *   - other formattable types are formatted eagerly on the caller's thread
+ *
+ * The format string itself is NOT copied: it must outlive the logger, which
+ * holds for the string literals every md::log_* call site passes.
+ * When a ring is full the record is dropped and counted (async_log_dropped).
+ */
+
+namespace md {
+
+enum class LogLevel;
+
+struct AsyncLogConfig {
+    std::size_t ring_bytes{1u << 20};                 // per producer thread
+    std::chrono::milliseconds flush_interval{5};
+    std::FILE* out{stdout};
+};
+
+void start_async_logging(const AsyncLogConfig& cfg = {});
+// Drains every ring, writes the remainder and returns to synchronous logging.
+void stop_async_logging();
+uint64_t async_log_dropped();
+
+namespace detail {
+
+inline std::atomic<bool>& async_log_flag() {
+    static std::atomic<bool> on{false};
+    return on;
+}
+
+inline bool async_log_on() {
+    return async_log_flag().load(std::memory_order_relaxed);
+}
+
+using LogDecodeFn = void (*)(std::string_view fmt_str, const char* args,
+                             fmt::memory_buffer& out);
+
+// Fixed part of every record in a ring. Records are 8-byte aligned;
+// level < 0 marks padding up to the end of the ring.
+struct LogRecordHeader {
+    uint32_t size;
+    int32_t level;
+    uint64_t ts_ns;
+    LogDecodeFn decode;
+    const char* fmt;
+    uint64_t fmt_len;
+};
+
+// Claims len bytes in the calling thread's ring; nullptr when it is full.
+char* log_ring_reserve(std::size_t len);
+// Publishes the record claimed by the last log_ring_reserve().
+void log_ring_commit();
+
+// --- argument capture ---
+
+template <typename T>
+inline auto log_prepare(const T& v) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        return v;
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        return std::string_view(v);
+    } else {
+        return fmt::format("{}", v);
+    }
+}
+
+template <typename P>
+using log_stored_t = std::conditional_t<std::is_arithmetic_v<P>, P, std::string_view>;
+
+template <typename P>
+inline std::size_t log_arg_size(const P& v) {
+    if constexpr (std::is_arithmetic_v<P>) {
+        return sizeof(P);
+    } else {
+        return sizeof(uint32_t) + std::string_view(v).size();
+    }
+}
+
+template <typename P>
+inline void log_arg_write(char*& p, const P& v) {
+    if constexpr (std::is_arithmetic_v<P>) {
+        std::memcpy(p, &v, sizeof(P));
+        p += sizeof(P);
+    } else {
+        std::string_view sv(v);
+        const auto n = static_cast<uint32_t>(sv.size());
+        std::memcpy(p, &n, sizeof(n));
+        std::memcpy(p + sizeof(n), sv.data(), n);
+        p += sizeof(n) + n;
+    }
+}
+
+template <typename S>
+inline S log_arg_read(const char*& p) {
+    if constexpr (std::is_arithmetic_v<S>) {
+        S v;
+        std::memcpy(&v, p, sizeof(S));
+        p += sizeof(S);
+        return v;
+    } else {
+        uint32_t n;
+        std::memcpy(&n, p, sizeof(n));
+        std::string_view sv(p + sizeof(n), n);
+        p += sizeof(n) + n;
+        return sv;
+    }
+}
+
+// Runs on the logger thread: rebuilds the arguments and formats them (p
+// goes unread for a message without arguments).
+template <typename... S>
+void log_decode(std::string_view fmt_str, [[maybe_unused]] const char* p,
+                fmt::memory_buffer& out) {
+    std::tuple<S...> vals{log_arg_read<S>(p)...}; // braced init: left to right
+    std::apply([&](auto&... v) {
+        fmt::vformat_to(std::back_inserter(out), fmt_str, fmt::make_format_args(v...));
+    }, vals);
+}
+
+template <typename... Args>
+inline void log_async(LogLevel lvl, std::string_view fmt_str, const Args&... args) {
+    auto prepared = std::make_tuple(log_prepare(args)...);
+
+    std::size_t len = sizeof(LogRecordHeader);
+    std::apply([&](const auto&... v) { ((len += log_arg_size(v)), ...); }, prepared);
+
+    char* p = log_ring_reserve(len);
+    if(!p) return;
+
+    LogRecordHeader hdr;
+    hdr.size = 0; // filled in by the ring
+    hdr.level = static_cast<int32_t>(lvl);
+    hdr.ts_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    hdr.decode = &log_decode<log_stored_t<std::decay_t<decltype(log_prepare(args))>>...>;
+    hdr.fmt = fmt_str.data();
+    hdr.fmt_len = fmt_str.size();
+    std::memcpy(p + sizeof(uint32_t), reinterpret_cast<const char*>(&hdr) + sizeof(uint32_t),
+                sizeof(hdr) - sizeof(uint32_t));
+
+    char* a = p + sizeof(LogRecordHeader);
+    std::apply([&](const auto&... v) { (log_arg_write(a, v), ...); }, prepared);
+    log_ring_commit();
+}
+
+}
+}
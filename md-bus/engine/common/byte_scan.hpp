@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace md {
+
+// --- Vectorized byte search ---
+//
+// find_byte(p, end, c) returns the first position of c in [p, end), or
+// end. Compares 32 bytes per step with AVX2 or 16 with SSE2 (every x86-64
+// has it); the tail and other targets use a plain loop. Build with
+// MD_NATIVE_ARCH=ON to let the compiler pick AVX2 where the host has it.
+//
+// The vector loops only load whole blocks inside [p, end), so there is no
+// need for padding after the buffer.
+
+namespace detail {
+
+inline const char* find_byte_scalar(const char* p, const char* end, char c) {
+    for(; p < end; ++p) {
+        if(*p == c) return p;
+    }
+    return end;
+}
+
+}
+
+inline const char* find_byte(const char* p, const char* end, char c) {
+#if defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi8(c);
+    for(; end - p >= 32; p += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+        if(mask) return p + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i needle16 = _mm_set1_epi8(c);
+    for(; end - p >= 16; p += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16)));
+        if(mask) return p + __builtin_ctz(mask);
+    }
+#endif
+    return detail::find_byte_scalar(p, end, c);
+}
+
+// string_view::find equivalent: index of c at or after from, or npos.
+template <typename View>
+inline std::size_t find_byte(View s, char c, std::size_t from = 0) {
+    if(from >= s.size()) return View::npos;
+    const char* end = s.data() + s.size();
+    const char* hit = find_byte(s.data() + from, end, c);
+    return hit == end ? View::npos : static_cast<std::size_t>(hit - s.data());
+}
+
+}
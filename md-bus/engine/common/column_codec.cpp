@@ -0,0 +1,399 @@
+#include "column_codec.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace md {
+
+namespace {
+
+constexpr double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+constexpr double kPow10Neg[] = {1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9};
+constexpr int kMaxPriceExp = 9;
+
+inline int bit_width(uint64_t v) {
+    return v ? 64 - __builtin_clzll(v) : 0;
+}
+
+inline double from_ticks(int64_t ticks, uint8_t mode) {
+    const int exp = mode & 0x0f;
+    return (mode & kPriceMultiply) ? static_cast<double>(ticks) * kPow10Neg[exp]
+                                   : static_cast<double>(ticks) / kPow10[exp];
+}
+
+// p as an integer number of ticks under mode, if that is lossless.
+inline bool to_ticks(double p, uint8_t mode, int64_t& ticks) {
+    const double x = p * kPow10[mode & 0x0f];
+    if(!(std::fabs(x) < 4.0e18)) return false; // also rejects NaN / inf
+    ticks = std::llround(x);
+    const double back = from_ticks(ticks, mode);
+    return back == p && std::signbit(back) == std::signbit(p);
+}
+
+// First mode under which every price is exact, or kRawPrices. Division
+// matches prices parsed from decimal text, multiplication matches prices
+// computed as k * 0.01.
+uint8_t choose_price_mode(const std::vector<double>& prices) {
+    for(uint8_t flag : {uint8_t{0}, kPriceMultiply}) {
+        for(int exp = 0; exp <= kMaxPriceExp; ++exp) {
+            const auto mode = static_cast<uint8_t>(flag | exp);
+            int64_t t;
+            bool all = true;
+            for(double p : prices) {
+                if(!to_ticks(p, mode, t)) { all = false; break; }
+            }
+            if(all) return mode;
+        }
+    }
+    return kRawPrices;
+}
+
+void put_column(std::string& out, const uint64_t* v, std::size_t n) {
+    uint64_t lo = n ? v[0] : 0;
+    uint64_t hi = lo;
+    for(std::size_t i = 1; i < n; ++i) {
+        lo = std::min(lo, v[i]);
+        hi = std::max(hi, v[i]);
+    }
+    const int w = bit_width(hi - lo);
+    put_varint(out, lo);
+    if(w > 56) {
+        out.push_back(static_cast<char>(kVarintColumn));
+        for(std::size_t i = 0; i < n; ++i) put_varint(out, v[i] - lo);
+        return;
+    }
+    out.push_back(static_cast<char>(w));
+    if(w == 0) return;
+
+    const std::size_t nbytes = (n * static_cast<std::size_t>(w) + 7) / 8;
+    const std::size_t base = out.size();
+    out.resize(base + nbytes + kColumnPad, '\0');
+    char* p = &out[base];
+    for(std::size_t i = 0; i < n; ++i) {
+        const std::size_t bit = i * static_cast<std::size_t>(w);
+        uint64_t word;
+        std::memcpy(&word, p + (bit >> 3), 8);
+        word |= (v[i] - lo) << (bit & 7);
+        std::memcpy(p + (bit >> 3), &word, 8);
+    }
+    out.resize(base + nbytes);
+}
+
+// Needs kColumnPad readable bytes after c.end.
+bool get_column(ByteCursor& c, std::size_t n, std::vector<uint64_t>& dst) {
+    const uint64_t lo = c.varint();
+    const uint8_t w = c.u8();
+    if(!c.ok) return false;
+    dst.resize(n);
+    if(w == kVarintColumn) {
+        for(std::size_t i = 0; i < n; ++i) dst[i] = lo + c.varint();
+        return c.ok;
+    }
+    if(w == 0) {
+        std::fill(dst.begin(), dst.end(), lo);
+        return true;
+    }
+    if(w > 56) return false;
+
+    const std::size_t nbytes = (n * w + 7) / 8;
+    if(static_cast<std::size_t>(c.end - c.p) < nbytes) return false;
+    const char* p = c.p;
+    const uint64_t mask = (uint64_t{1} << w) - 1;
+    uint64_t* d = dst.data();
+    for(std::size_t i = 0; i < n; ++i) {
+        const std::size_t bit = i * w;
+        uint64_t word;
+        std::memcpy(&word, p + (bit >> 3), 8);
+        d[i] = lo + ((word >> (bit & 7)) & mask);
+    }
+    c.p += nbytes;
+    return true;
+}
+
+inline PayloadKind kind_of(const Payload& p) {
+    if(std::holds_alternative<Tick>(p)) return PayloadKind::Tick;
+    if(std::holds_alternative<Bar>(p)) return PayloadKind::Bar;
+    if(std::holds_alternative<std::string>(p)) return PayloadKind::Log;
+    return PayloadKind::None;
+}
+
+}
+
+void ColumnBlockEncoder::encode_block(std::string& out) {
+    const std::size_t n = rows_.size();
+    if(n == 0) return;
+
+    const std::size_t start = out.size();
+    out.append(kColumnBlockHeaderSize, '\0');
+
+    // price mode
+    prices_.clear();
+    for(const auto& e : rows_) {
+        if(const auto* t = std::get_if<Tick>(&e.p)) {
+            prices_.push_back(t->pq);
+        } else if(const auto* b = std::get_if<Bar>(&e.p)) {
+            prices_.insert(prices_.end(), {b->open, b->high, b->low, b->close});
+        }
+    }
+    const uint8_t exp = choose_price_mode(prices_);
+    out.push_back(static_cast<char>(exp));
+
+    // symbol ids, extending the dictionary
+    std::vector<uint32_t> ids;
+    ids.reserve(n);
+    for(const auto& e : rows_) {
+        if(const std::string* sym = payload_symbol(e.p)) {
+            auto [it, inserted] = symbols_.try_emplace(*sym, static_cast<uint32_t>(symbol_names_.size()));
+            if(inserted) symbol_names_.push_back(*sym);
+            ids.push_back(it->second);
+        }
+    }
+    put_varint(out, flushed_symbols_);
+    put_varint(out, symbol_names_.size() - flushed_symbols_);
+    for(std::size_t s = flushed_symbols_; s < symbol_names_.size(); ++s) {
+        put_varint(out, symbol_names_[s].size());
+        out.append(symbol_names_[s]);
+    }
+    flushed_symbols_ = symbol_names_.size();
+
+    // kind, topic
+    col_.resize(n);
+    for(std::size_t i = 0; i < n; ++i) col_[i] = static_cast<uint64_t>(kind_of(rows_[i].p));
+    put_column(out, col_.data(), n);
+    for(std::size_t i = 0; i < n; ++i) col_[i] = static_cast<uint64_t>(rows_[i].h.topic);
+    put_column(out, col_.data(), n);
+
+    // seq, ts
+    put_varint(out, rows_[0].h.seq);
+    for(std::size_t i = 1; i < n; ++i) {
+        col_[i - 1] = zigzag(static_cast<int64_t>(rows_[i].h.seq - rows_[i - 1].h.seq));
+    }
+    put_column(out, col_.data(), n - 1);
+    put_varint(out, rows_[0].h.ts_ns);
+    for(std::size_t i = 1; i < n; ++i) {
+        col_[i - 1] = zigzag(static_cast<int64_t>(rows_[i].h.ts_ns - rows_[i - 1].h.ts_ns));
+    }
+    put_column(out, col_.data(), n - 1);
+
+    col_.assign(ids.begin(), ids.end());
+    put_column(out, col_.data(), col_.size());
+
+    // ticks: price deltas per symbol, then quantities
+    if(last_px_.size() < symbol_names_.size()) last_px_.resize(symbol_names_.size(), 0);
+    std::vector<uint32_t> touched;
+    col_.clear();
+    std::size_t k = 0;
+    for(const auto& e : rows_) {
+        const auto* t = std::get_if<Tick>(&e.p);
+        const bool has_sym = t || std::holds_alternative<Bar>(e.p);
+        const uint32_t id = has_sym ? ids[k++] : 0;
+        if(!t) continue;
+        if(exp == kRawPrices) {
+            put_f64(out, t->pq);
+            continue;
+        }
+        int64_t ticks = 0;
+        to_ticks(t->pq, exp, ticks);
+        col_.push_back(zigzag(ticks - last_px_[id]));
+        if(last_px_[id] == 0) touched.push_back(id);
+        last_px_[id] = ticks;
+    }
+    if(exp != kRawPrices) put_column(out, col_.data(), col_.size());
+    for(uint32_t id : touched) last_px_[id] = 0; // blocks stand alone
+
+    col_.clear();
+    for(const auto& e : rows_) {
+        if(const auto* t = std::get_if<Tick>(&e.p)) col_.push_back(t->qty);
+    }
+    put_column(out, col_.data(), col_.size());
+
+    // bars (length-prefixed so logs can be found without parsing them)
+    std::string bars;
+    for(const auto& e : rows_) {
+        const auto* b = std::get_if<Bar>(&e.p);
+        if(!b) continue;
+        if(exp == kRawPrices) {
+            put_f64(bars, b->open);
+            put_f64(bars, b->high);
+            put_f64(bars, b->low);
+            put_f64(bars, b->close);
+        } else {
+            int64_t o = 0, h = 0, l = 0, c = 0;
+            to_ticks(b->open, exp, o);
+            to_ticks(b->high, exp, h);
+            to_ticks(b->low, exp, l);
+            to_ticks(b->close, exp, c);
+            put_varint(bars, zigzag(o));
+            put_varint(bars, zigzag(h - o));
+            put_varint(bars, zigzag(o - l));
+            put_varint(bars, zigzag(c - o));
+        }
+        put_varint(bars, zigzag(b->volume));
+        put_varint(bars, zigzag(static_cast<int64_t>(b->start_ts_ns - e.h.ts_ns)));
+        put_varint(bars, zigzag(static_cast<int64_t>(b->end_ts_ns - e.h.ts_ns)));
+    }
+    put_varint(out, bars.size());
+    out.append(bars);
+
+    for(const auto& e : rows_) {
+        if(const auto* msg = std::get_if<std::string>(&e.p)) {
+            put_varint(out, msg->size());
+            out.append(*msg);
+        }
+    }
+
+    const auto body_bytes = static_cast<uint32_t>(out.size() - start - kColumnBlockHeaderSize);
+    const auto n_events = static_cast<uint32_t>(n);
+    std::memcpy(&out[start], &body_bytes, 4);
+    std::memcpy(&out[start + 4], &n_events, 4);
+    rows_.clear();
+}
+
+bool ColumnBlockDecoder::decode_block(const char* body, std::size_t body_bytes, uint32_t n,
+                                      std::vector<Event>& events, const EventPrefilter* pre) {
+    if(n == 0) return false;
+    ByteCursor c{body, body + body_bytes};
+
+    const uint8_t exp = c.u8();
+    if(exp != kRawPrices && ((exp & 0x0f) > kMaxPriceExp || (exp & ~(kPriceMultiply | 0x0f)))) {
+        return false;
+    }
+
+    const uint64_t first_new = c.varint();
+    const uint64_t n_new = c.varint();
+    if(!c.ok || first_new > symbols_.size()) return false;
+    for(uint64_t s = 0; s < n_new; ++s) {
+        std::string_view name = c.bytes(c.varint());
+        if(!c.ok) return false;
+        // ids below size() are already known from set_symbols()
+        if(first_new + s == symbols_.size()) symbols_.emplace_back(name);
+    }
+
+    if(!get_column(c, n, kind_) || !get_column(c, n, topic_)) return false;
+    const uint64_t seq0 = c.varint();
+    if(!c.ok || !get_column(c, n - 1, seq_)) return false;
+    const uint64_t ts0 = c.varint();
+    if(!c.ok || !get_column(c, n - 1, ts_)) return false;
+
+    std::size_t n_sym = 0, n_tick = 0;
+    for(uint64_t k : kind_) {
+        if(k > static_cast<uint64_t>(PayloadKind::Bar)) return false;
+        n_tick += k == static_cast<uint64_t>(PayloadKind::Tick);
+        n_sym += k == static_cast<uint64_t>(PayloadKind::Tick) || k == static_cast<uint64_t>(PayloadKind::Bar);
+    }
+    if(!get_column(c, n_sym, sym_)) return false;
+    for(uint64_t id : sym_) {
+        if(id >= symbols_.size()) return false;
+    }
+
+    const char* raw_px = nullptr;
+    if(exp == kRawPrices) {
+        raw_px = c.p;
+        c.bytes(8 * n_tick);
+    } else if(!get_column(c, n_tick, px_)) {
+        return false;
+    }
+    if(!c.ok || !get_column(c, n_tick, qty_)) return false;
+
+    const uint64_t bars_len = c.varint();
+    ByteCursor bars{c.p, c.p};
+    if(c.ok) {
+        const std::string_view b = c.bytes(bars_len);
+        bars = ByteCursor{b.data(), b.data() + b.size()};
+    }
+    if(!c.ok) return false;
+
+    if(last_px_.size() < symbols_.size()) last_px_.resize(symbols_.size(), 0);
+    std::vector<uint32_t> touched;
+
+    events.resize(n);
+    uint64_t seq = seq0;
+    uint64_t ts = ts0;
+    std::size_t si = 0, ti = 0, kept = 0;
+    bool ok = true;
+    for(std::size_t i = 0; i < n && ok; ++i) {
+        if(i > 0) {
+            seq += static_cast<uint64_t>(unzigzag(seq_[i - 1]));
+            ts += static_cast<uint64_t>(unzigzag(ts_[i - 1]));
+        }
+        const auto kind = static_cast<PayloadKind>(kind_[i]);
+        const bool has_symbol = kind == PayloadKind::Tick || kind == PayloadKind::Bar;
+        const auto id = has_symbol ? static_cast<uint32_t>(sym_[si++]) : 0u;
+        const auto topic = static_cast<Topic>(topic_[i]);
+        const bool keep = !pre ||
+            (pre->admits_header(ts, topic) &&
+             (!pre->by_symbol() || (kind == PayloadKind::Tick && pre->admits_symbol_id(id, symbols_))));
+
+        // Rejected rows still advance the per-symbol prices and the bar /
+        // log byte streams, but build nothing.
+        Event* e = keep ? &events[kept++] : nullptr;
+        if(e) {
+            e->h.seq = seq;
+            e->h.ts_ns = ts;
+            e->h.topic = topic;
+        }
+
+        switch(kind) {
+            case PayloadKind::None :
+                if(e) e->p = std::monostate{};
+                break;
+            case PayloadKind::Tick : {
+                double pq = 0.0;
+                if(raw_px) {
+                    std::memcpy(&pq, raw_px + 8 * ti, 8);
+                } else {
+                    if(last_px_[id] == 0) touched.push_back(id);
+                    last_px_[id] += unzigzag(px_[ti]);
+                    if(e) pq = from_ticks(last_px_[id], exp);
+                }
+                if(e) {
+                    Tick& t = emplace_reuse<Tick>(e->p);
+                    t.symbol = symbols_[id];
+                    t.pq = pq;
+                    t.qty = static_cast<uint32_t>(qty_[ti]);
+                }
+                ++ti;
+                break;
+            }
+            case PayloadKind::Bar : {
+                if(!e) {
+                    if(raw_px) bars.bytes(4 * 8);
+                    else for(int k = 0; k < 4; ++k) bars.varint();
+                    for(int k = 0; k < 3; ++k) bars.varint();
+                    ok = bars.ok;
+                    break;
+                }
+                Bar& b = emplace_reuse<Bar>(e->p);
+                b.symbol = symbols_[id];
+                if(raw_px) {
+                    b.open = bars.f64();
+                    b.high = bars.f64();
+                    b.low = bars.f64();
+                    b.close = bars.f64();
+                } else {
+                    const int64_t o = unzigzag(bars.varint());
+                    b.open = from_ticks(o, exp);
+                    b.high = from_ticks(o + unzigzag(bars.varint()), exp);
+                    b.low = from_ticks(o - unzigzag(bars.varint()), exp);
+                    b.close = from_ticks(o + unzigzag(bars.varint()), exp);
+                }
+                b.volume = static_cast<int>(unzigzag(bars.varint()));
+                b.start_ts_ns = ts + static_cast<uint64_t>(unzigzag(bars.varint()));
+                b.end_ts_ns = ts + static_cast<uint64_t>(unzigzag(bars.varint()));
+                ok = bars.ok;
+                break;
+            }
+            case PayloadKind::Log : {
+                std::string_view msg = c.bytes(c.varint());
+                if(e) emplace_reuse<std::string>(e->p).assign(msg.data(), msg.size());
+                ok = c.ok;
+                break;
+            }
+        }
+    }
+    events.resize(kept);
+    for(uint32_t id : touched) last_px_[id] = 0;
+    return ok;
+}
+
+}
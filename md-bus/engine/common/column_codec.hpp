@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "event.hpp"
+#include "event_binary.hpp"
+
+namespace md {
+
+// --- Columnar block codec ---
+//
+// File header: same 16-byte layout as the binary format with magic "MDCC".
+// Then a sequence of blocks:
+//
+//   u32 body_bytes | u32 n_events | body [| u32 crc32c]
+//
+// The CRC32C of header and body is present when the file header has
+// kBinaryFlagChecksummed.
+//
+// body:
+//   u8 price_mode         low 4 bits e: prices are integer ticks t with
+//                         price == t / 10^e, or t * 10^-e when the
+//                         kPriceMultiply bit is set (the two round
+//                         differently); kRawPrices when neither is exact
+//                         for every price in the block (raw f64 bits)
+//   varint first_new_sym | varint n_new | n_new x { varint len | name }
+//   column kind[n]        PayloadKind per row
+//   column topic[n]
+//   varint seq0 | column zz(seq delta)[n-1]
+//   varint ts0  | column zz(ts delta)[n-1]
+//   column sym[rows with a symbol]
+//   Tick rows:  column zz(price - previous price of that symbol in this block)
+//               column qty
+//   Bar rows:   per bar zz varints open | high-open | open-low | close-open
+//               | zz(volume) | zz(start-ts) | zz(end-ts)      (f64s when raw)
+//   Log rows:   per row varint len | bytes
+//
+// A column is frame-of-reference bit-packed: varint min | u8 width |
+// ceil(n * width / 8) bytes, LSB first. width 0 means every value equals
+// min (seq deltas, topics of a pure tick block); width kVarintColumn means
+// the values follow as varints of (value - min) (range needs more than 56
+// bits).
+//
+// Unpacking is a fixed-stride loop of unaligned 64-bit loads, shift and
+// mask with no data-dependent branches, so the compiler can vectorize it;
+// the loads are why decode buffers carry kColumnPad bytes of slack.
+//
+// The symbol dictionary is shared by the whole file (ids in first-seen
+// order, as in the binary format). Everything else restarts per block, so a
+// reader can start at any block given the dictionary.
+
+inline constexpr char kColumnarMagic[4] = {'M', 'D', 'C', 'C'};
+inline constexpr uint16_t kColumnarVersion = 1;
+inline constexpr std::size_t kColumnBlockHeaderSize = 8;
+inline constexpr std::size_t kColumnPad = 8;
+inline constexpr uint8_t kRawPrices = 0xff;
+inline constexpr uint8_t kPriceMultiply = 0x10;
+inline constexpr uint8_t kVarintColumn = 0xff;
+
+inline void write_columnar_file_header(std::string& out, uint16_t flags = 0) {
+    write_binary_file_header(out, flags);
+    std::memcpy(&out[out.size() - kBinaryFileHeaderSize], kColumnarMagic, 4);
+}
+
+// Checks the magic and version; fills flags. Needs kBinaryFileHeaderSize bytes.
+inline bool read_columnar_file_header(std::string_view data, uint16_t& flags) {
+    if(data.size() < kBinaryFileHeaderSize) return false;
+    if(std::memcmp(data.data(), kColumnarMagic, 4) != 0) return false;
+    const auto* u = reinterpret_cast<const unsigned char*>(data.data());
+    flags = static_cast<uint16_t>(u[6] | (u[7] << 8));
+    return static_cast<uint16_t>(u[4] | (u[5] << 8)) == kColumnarVersion;
+}
+
+inline bool looks_like_columnar_log(std::string_view first_bytes) {
+    return first_bytes.size() >= kBinaryFileHeaderSize &&
+           std::memcmp(first_bytes.data(), kColumnarMagic, 4) == 0;
+}
+
+// Reads the u32 pair in front of a block.
+inline void read_column_block_header(const char* p, uint32_t& body_bytes, uint32_t& n_events) {
+    std::memcpy(&body_bytes, p, 4);
+    std::memcpy(&n_events, p + 4, 4);
+}
+
+/*
+ * ColumnBlockEncoder
+ * ------------------
+ * Collects events with add() and turns them into one block with
+ * encode_block(). Keeps the file-wide symbol dictionary between blocks.
+ */
+class ColumnBlockEncoder {
+private :
+    std::vector<Event> rows_;
+    std::unordered_map<std::string, uint32_t> symbols_;
+    std::size_t flushed_symbols_{0};
+    std::vector<std::string> symbol_names_;
+
+    // scratch
+    std::vector<uint64_t> col_;
+    std::vector<double> prices_;
+    std::vector<int64_t> last_px_;
+public :
+    void add(const Event& e) { rows_.push_back(e); }
+    std::size_t pending() const { return rows_.size(); }
+
+    // Continues a file whose blocks already define syms (ids in order).
+    void set_symbols(const std::vector<std::string>& syms) {
+        symbols_.clear();
+        for(std::size_t i = 0; i < syms.size(); ++i) symbols_.emplace(syms[i], static_cast<uint32_t>(i));
+        symbol_names_ = syms;
+        flushed_symbols_ = syms.size();
+    }
+
+    // Appends header + body for the pending events (if any) to out.
+    void encode_block(std::string& out);
+};
+
+/*
+ * ColumnBlockDecoder
+ * ------------------
+ * decode_block() takes one block body (kColumnPad readable bytes past its
+ * end) and fills events[0, n). Event objects are reused across blocks.
+ * With a prefilter, rows are judged on the ts / topic / symbol columns and
+ * only the accepted ones are materialized; events is resized to match.
+ */
+class ColumnBlockDecoder {
+private :
+    std::vector<std::string> symbols_;
+    std::vector<uint64_t> kind_, topic_, seq_, ts_, sym_, px_, qty_;
+    std::vector<int64_t> last_px_;
+public :
+    bool decode_block(const char* body, std::size_t body_bytes, uint32_t n_events,
+                      std::vector<Event>& events, const EventPrefilter* pre = nullptr);
+
+    const std::vector<std::string>& symbols() const { return symbols_; }
+    void set_symbols(std::vector<std::string> syms) { symbols_ = std::move(syms); }
+};
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace md {
+
+// --- CRC32C (Castagnoli) ---
+//
+// crc32c(p, n) checksums a buffer; crc32c(p, n, prev) continues a previous
+// result, so crc32c(b, nb, crc32c(a, na)) == crc32c(a + b). Uses the SSE4.2
+// crc32 instruction when the build enables it (MD_NATIVE_ARCH=ON on a host
+// that has it), slicing-by-8 tables otherwise.
+
+namespace detail {
+
+inline constexpr uint32_t kCrc32cPoly = 0x82f63b78u; // reflected
+
+constexpr std::array<std::array<uint32_t, 256>, 8> make_crc32c_tables() {
+    std::array<std::array<uint32_t, 256>, 8> t{};
+    for(uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for(int k = 0; k < 8; ++k) c = (c >> 1) ^ ((c & 1) ? kCrc32cPoly : 0);
+        t[0][i] = c;
+    }
+    for(uint32_t i = 0; i < 256; ++i) {
+        for(std::size_t s = 1; s < 8; ++s) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+    }
+    return t;
+}
+
+inline constexpr auto kCrc32cTables = make_crc32c_tables();
+
+}
+
+inline uint32_t crc32c(const void* data, std::size_t n, uint32_t prev = 0) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    uint32_t c = ~prev;
+#if defined(__SSE4_2__)
+    uint64_t c64 = c;
+    for(; n >= 8; n -= 8, p += 8) {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        c64 = _mm_crc32_u64(c64, w);
+    }
+    c = static_cast<uint32_t>(c64);
+    for(; n > 0; --n) c = _mm_crc32_u8(c, *p++);
+#else
+    const auto& t = detail::kCrc32cTables;
+    for(; n >= 8; n -= 8, p += 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= c;
+        c = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    }
+    for(; n > 0; --n) c = (c >> 8) ^ t[0][(c ^ *p++) & 0xff];
+#endif
+    return ~c;
+}
+
+// Little-endian u32, as stored after checksummed records.
+inline void put_u32(std::string& out, uint32_t v) {
+    char b[4];
+    std::memcpy(b, &v, 4);
+    out.append(b, 4);
+}
+
+inline uint32_t get_u32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+}
@@ -11,7 +11,9 @@ enum class Topic : uint8_t {
     MD_TICK = 1,
     HEARTBEAT = 2, 
     BAR_1S = 3,
-    BAR_1M = 4
+    BAR_1M = 4,
+    BAR_5M = 5,
+    BAR_CUSTOM = 6  // any other bar timeframe (see BarTimeframe)
     // MD_TRADE,
     // ORDER,
     // BOOK_UPDATE,
@@ -48,6 +50,14 @@ struct Event {
     Payload p;
 };
 
+// The T held by p, or a fresh one. Decoders use it so an Event reused from
+// record to record keeps its strings' capacity.
+template <typename T>
+T& emplace_reuse(Payload& p) {
+    if(auto* v = std::get_if<T>(&p)) return *v;
+    return p.emplace<T>();
+}
+
 inline uint64_t now_ns() {
     using namespace std::chrono;
     return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().
@@ -0,0 +1,459 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "crc32c.hpp"
+#include "event.hpp"
+#include "event_filter.hpp"
+
+namespace md {
+
+// --- Binary record format (version 1) ---
+//
+// File header (16 bytes):
+//   "MDEV" | u16 version | u16 flags | u64 reserved
+//
+//   flags bit 0 (kBinaryFlagZeroTerminated): the file is pre-allocated
+//   (journal segment) and a zero type byte marks the end of the data.
+//   flags bit 1 (kBinaryFlagChecksummed): every record is followed by a u32
+//   CRC32C of its type, length and body, so a torn or damaged record is
+//   detected rather than misread.
+//
+// Then a sequence of records:
+//   u8 type | varint body_len | body [| u32 crc32c]
+//
+//   EVENT  body: u8 topic | u8 kind | zz(seq - prev_seq) | zz(ts - prev_ts) | payload
+//          kind 0 monostate: (nothing)
+//          kind 1 Tick:      varint sym_id | f64 pq | varint qty
+//          kind 2 Log:       varint len | bytes
+//          kind 3 Bar:       varint sym_id | f64 open | f64 high | f64 low | f64 close
+//                            | zz(volume) | zz(start_ts - ts) | zz(end_ts - ts)
+//   SYMBOL body: varint sym_id | name bytes   (emitted before first use)
+//   SYNC   body: (empty) resets prev_seq / prev_ts to 0, so the next EVENT
+//                carries absolute values and decoding can start there given
+//                the symbol table.
+//
+// varint = LEB128, zz = zig-zag varint, f64 = raw little-endian IEEE bits
+// (lossless, unlike the text format's decimal rendering).
+// Every record is length-prefixed, so readers skip unknown record types.
+
+// On-disk encodings understood by EventRecorder / EventReplay
+enum class RecordFormat {
+    Text,      // CSV lines, see event_io.hpp
+    Binary,    // this file
+    Columnar,  // compressed column blocks, see column_codec.hpp
+};
+
+inline const char* to_string(RecordFormat f) {
+    switch(f) {
+        case RecordFormat::Text : return "text";
+        case RecordFormat::Binary : return "binary";
+        case RecordFormat::Columnar : return "columnar";
+    }
+    return "unknown";
+}
+
+inline constexpr char kBinaryMagic[4] = {'M', 'D', 'E', 'V'};
+inline constexpr uint16_t kBinaryVersion = 1;
+inline constexpr std::size_t kBinaryFileHeaderSize = 16;
+inline constexpr uint16_t kBinaryFlagZeroTerminated = 0x1;
+inline constexpr uint16_t kBinaryFlagChecksummed = 0x2;
+inline constexpr std::size_t kRecordChecksumSize = 4;
+
+enum class RecordType : uint8_t {
+    Event = 1,
+    Symbol = 2,
+    Sync = 3,
+};
+
+enum class PayloadKind : uint8_t {
+    None = 0,
+    Tick = 1,
+    Log = 2,
+    Bar = 3,
+};
+
+// --- primitive encoders ---
+
+inline void put_varint(std::string& out, uint64_t v) {
+    while(v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+inline uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline void put_f64(std::string& out, double d) {
+    char b[8];
+    std::memcpy(b, &d, 8);
+    out.append(b, 8);
+}
+
+inline std::size_t varint_size(uint64_t v) {
+    std::size_t n = 1;
+    while(v >= 0x80) { v >>= 7; ++n; }
+    return n;
+}
+
+// Bounds-checked cursor over a byte range; any overrun sets ok = false.
+struct ByteCursor {
+    const char* p;
+    const char* end;
+    bool ok{true};
+
+    uint8_t u8() {
+        if(p >= end) { ok = false; return 0; }
+        return static_cast<uint8_t>(*p++);
+    }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for(int shift = 0; shift < 64; shift += 7) {
+            if(p >= end) { ok = false; return 0; }
+            const auto b = static_cast<uint8_t>(*p++);
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if(!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+    double f64() {
+        if(end - p < 8) { ok = false; return 0.0; }
+        double d;
+        std::memcpy(&d, p, 8);
+        p += 8;
+        return d;
+    }
+    std::string_view bytes(std::size_t n) {
+        if(static_cast<std::size_t>(end - p) < n) { ok = false; return {}; }
+        std::string_view s(p, n);
+        p += n;
+        return s;
+    }
+};
+
+inline void write_binary_file_header(std::string& out, uint16_t flags = 0) {
+    out.append(kBinaryMagic, 4);
+    out.push_back(static_cast<char>(kBinaryVersion & 0xff));
+    out.push_back(static_cast<char>(kBinaryVersion >> 8));
+    out.push_back(static_cast<char>(flags & 0xff));
+    out.push_back(static_cast<char>(flags >> 8));
+    out.append(8, '\0');
+}
+
+// Checks the magic and version; fills flags. Needs kBinaryFileHeaderSize bytes.
+inline bool read_binary_file_header(std::string_view data, uint16_t& flags) {
+    if(data.size() < kBinaryFileHeaderSize) return false;
+    if(std::memcmp(data.data(), kBinaryMagic, 4) != 0) return false;
+    const auto* u = reinterpret_cast<const unsigned char*>(data.data());
+    const uint16_t version = static_cast<uint16_t>(u[4] | (u[5] << 8));
+    flags = static_cast<uint16_t>(u[6] | (u[7] << 8));
+    return version == kBinaryVersion;
+}
+
+inline bool looks_like_binary_log(std::string_view first_bytes) {
+    return first_bytes.size() >= 4 && std::memcmp(first_bytes.data(), kBinaryMagic, 4) == 0;
+}
+
+// Symbol of a Tick or Bar payload, nullptr for anything else.
+inline const std::string* payload_symbol(const Payload& p) {
+    if(const auto* t = std::get_if<Tick>(&p)) return &t->symbol;
+    if(const auto* b = std::get_if<Bar>(&p)) return &b->symbol;
+    return nullptr;
+}
+
+/*
+ * BinaryEventWriter
+ * -----------------
+ * Stateful encoder: tracks the previous seq / ts for deltas and the symbol
+ * table. Appends complete records to a caller-owned buffer.
+ */
+class BinaryEventWriter {
+private :
+    uint64_t prev_seq_{0};
+    uint64_t prev_ts_{0};
+    std::unordered_map<std::string, uint32_t> symbols_;
+    std::string body_;
+    bool checksums_{false};
+
+    void put_record(std::string& out, RecordType type) {
+        const std::size_t start = out.size();
+        out.push_back(static_cast<char>(type));
+        put_varint(out, body_.size());
+        out.append(body_);
+        if(checksums_) put_u32(out, crc32c(out.data() + start, out.size() - start));
+    }
+
+    uint32_t intern(std::string& out, const std::string& sym) {
+        auto it = symbols_.find(sym);
+        if(it != symbols_.end()) return it->second;
+        const auto id = static_cast<uint32_t>(symbols_.size());
+        symbols_.emplace(sym, id);
+        body_.clear();
+        put_varint(body_, id);
+        body_.append(sym);
+        put_record(out, RecordType::Symbol);
+        return id;
+    }
+public :
+    void encode(const Event& e, std::string& out) {
+        // symbol definitions go out before the event that needs them
+        uint32_t sym_id = 0;
+        if(const std::string* sym = payload_symbol(e.p)) {
+            sym_id = intern(out, *sym);
+        }
+
+        body_.clear();
+        body_.push_back(static_cast<char>(e.h.topic));
+
+        const int64_t dseq = static_cast<int64_t>(e.h.seq - prev_seq_);
+        const int64_t dts = static_cast<int64_t>(e.h.ts_ns - prev_ts_);
+        prev_seq_ = e.h.seq;
+        prev_ts_ = e.h.ts_ns;
+
+        if(const auto* t = std::get_if<Tick>(&e.p)) {
+            body_.push_back(static_cast<char>(PayloadKind::Tick));
+            put_varint(body_, zigzag(dseq));
+            put_varint(body_, zigzag(dts));
+            put_varint(body_, sym_id);
+            put_f64(body_, t->pq);
+            put_varint(body_, t->qty);
+        } else if(const auto* b = std::get_if<Bar>(&e.p)) {
+            body_.push_back(static_cast<char>(PayloadKind::Bar));
+            put_varint(body_, zigzag(dseq));
+            put_varint(body_, zigzag(dts));
+            put_varint(body_, sym_id);
+            put_f64(body_, b->open);
+            put_f64(body_, b->high);
+            put_f64(body_, b->low);
+            put_f64(body_, b->close);
+            put_varint(body_, zigzag(b->volume));
+            put_varint(body_, zigzag(static_cast<int64_t>(b->start_ts_ns - e.h.ts_ns)));
+            put_varint(body_, zigzag(static_cast<int64_t>(b->end_ts_ns - e.h.ts_ns)));
+        } else if(const auto* msg = std::get_if<std::string>(&e.p)) {
+            body_.push_back(static_cast<char>(PayloadKind::Log));
+            put_varint(body_, zigzag(dseq));
+            put_varint(body_, zigzag(dts));
+            put_varint(body_, msg->size());
+            body_.append(*msg);
+        } else {
+            body_.push_back(static_cast<char>(PayloadKind::None));
+            put_varint(body_, zigzag(dseq));
+            put_varint(body_, zigzag(dts));
+        }
+        put_record(out, RecordType::Event);
+    }
+
+    // Emits a SYNC record: the next event is encoded with absolute seq / ts.
+    void sync(std::string& out) {
+        prev_seq_ = 0;
+        prev_ts_ = 0;
+        body_.clear();
+        put_record(out, RecordType::Sync);
+    }
+
+    std::size_t symbol_count() const { return symbols_.size(); }
+
+    // Matches the kBinaryFlagChecksummed header flag of the file written to.
+    void set_checksums(bool on) { checksums_ = on; }
+
+    // Continues a file whose symbol records (ids in order) are already written.
+    void set_symbols(const std::vector<std::string>& syms) {
+        symbols_.clear();
+        for(std::size_t i = 0; i < syms.size(); ++i) symbols_.emplace(syms[i], static_cast<uint32_t>(i));
+    }
+};
+
+enum class DecodeStatus {
+    Event,      // out holds the next event
+    End,        // no bytes left
+    Truncated,  // record runs past the end of the data (torn write / need more)
+    Corrupt,    // malformed record
+};
+
+/*
+ * BinaryEventReader
+ * -----------------
+ * Mirror of BinaryEventWriter. decode() consumes records from [p, end)
+ * until it produces an event; SYMBOL and SYNC records are applied to the
+ * reader state on the way.
+ */
+class BinaryEventReader {
+private :
+    uint64_t prev_seq_{0};
+    uint64_t prev_ts_{0};
+    std::vector<std::string> symbols_;
+    bool checksums_{false};
+
+    bool symbol(uint64_t id, std::string& out) const {
+        if(id >= symbols_.size()) return false;
+        out = symbols_[id];
+        return true;
+    }
+
+    const EventPrefilter* pre_{nullptr};
+    uint64_t filtered_{0};
+    std::size_t event_at_{0};
+
+    // skipped: the prefilter rejected the record after its header (or
+    // symbol id); out then holds the header only.
+    bool decode_event(ByteCursor& c, Event& out, bool& skipped) {
+        const uint8_t topic = c.u8();
+        const auto kind = static_cast<PayloadKind>(c.u8());
+        const int64_t dseq = unzigzag(c.varint());
+        const int64_t dts = unzigzag(c.varint());
+        if(!c.ok) return false;
+
+        out.h.topic = static_cast<Topic>(topic);
+        out.h.seq = prev_seq_ + static_cast<uint64_t>(dseq);
+        out.h.ts_ns = prev_ts_ + static_cast<uint64_t>(dts);
+        prev_seq_ = out.h.seq;
+        prev_ts_ = out.h.ts_ns;
+
+        skipped = false;
+        if(pre_) {
+            if(!pre_->admits_header(out.h.ts_ns, out.h.topic)) {
+                skipped = true;
+                return true;
+            }
+            if(pre_->by_symbol()) {
+                if(kind != PayloadKind::Tick) {
+                    skipped = true;
+                    return true;
+                }
+                ByteCursor peek = c;
+                const uint64_t id = peek.varint();
+                if(peek.ok && !pre_->admits_symbol_id(id, symbols_)) {
+                    skipped = true;
+                    return true;
+                }
+            }
+        }
+
+        switch(kind) {
+            case PayloadKind::None :
+                out.p = std::monostate{};
+                return true;
+            case PayloadKind::Tick : {
+                Tick& t = emplace_reuse<Tick>(out.p);
+                if(!symbol(c.varint(), t.symbol)) return false;
+                t.pq = c.f64();
+                t.qty = static_cast<uint32_t>(c.varint());
+                return c.ok;
+            }
+            case PayloadKind::Log : {
+                const uint64_t n = c.varint();
+                out.p = std::string(c.bytes(n));
+                return c.ok;
+            }
+            case PayloadKind::Bar : {
+                Bar b;
+                if(!symbol(c.varint(), b.symbol)) return false;
+                b.open = c.f64();
+                b.high = c.f64();
+                b.low = c.f64();
+                b.close = c.f64();
+                b.volume = static_cast<int>(unzigzag(c.varint()));
+                b.start_ts_ns = out.h.ts_ns + static_cast<uint64_t>(unzigzag(c.varint()));
+                b.end_ts_ns = out.h.ts_ns + static_cast<uint64_t>(unzigzag(c.varint()));
+                out.p = std::move(b);
+                return c.ok;
+            }
+        }
+        return false;
+    }
+public :
+    // Decodes from [p, end). consumed = bytes used, including the records
+    // before the returned event. On Truncated / Corrupt, consumed stops at the
+    // start of the offending record.
+    DecodeStatus decode(const char* p, const char* end, Event& out, std::size_t& consumed) {
+        const char* start = p;
+        consumed = 0;
+        while(p < end) {
+            ByteCursor hdr{p, end};
+            const uint8_t type = hdr.u8();
+            const uint64_t len = hdr.varint();
+            if(!hdr.ok || static_cast<uint64_t>(end - hdr.p) < len) {
+                return DecodeStatus::Truncated;
+            }
+            ByteCursor body{hdr.p, hdr.p + len};
+            const char* next = hdr.p + len;
+            if(checksums_) {
+                if(static_cast<std::size_t>(end - next) < kRecordChecksumSize) {
+                    return DecodeStatus::Truncated;
+                }
+                if(get_u32(next) != crc32c(p, static_cast<std::size_t>(next - p))) {
+                    return DecodeStatus::Corrupt;
+                }
+                next += kRecordChecksumSize;
+            }
+
+            switch(static_cast<RecordType>(type)) {
+                case RecordType::Event : {
+                    bool skipped = false;
+                    if(!decode_event(body, out, skipped)) return DecodeStatus::Corrupt;
+                    if(skipped) {
+                        ++filtered_;
+                        break;
+                    }
+                    event_at_ = static_cast<std::size_t>(p - start);
+                    consumed = static_cast<std::size_t>(next - start);
+                    return DecodeStatus::Event;
+                }
+                case RecordType::Symbol : {
+                    const uint64_t id = body.varint();
+                    if(!body.ok || id > symbols_.size()) return DecodeStatus::Corrupt;
+                    // id < size: already known from set_symbols() (reader seeked
+                    // past the definition and back)
+                    if(id == symbols_.size()) {
+                        symbols_.emplace_back(body.p, static_cast<std::size_t>(body.end - body.p));
+                    }
+                    break;
+                }
+                case RecordType::Sync :
+                    prev_seq_ = 0;
+                    prev_ts_ = 0;
+                    break;
+                default :
+                    if(type == 0) return DecodeStatus::Corrupt;
+                    break; // unknown but well-formed: skip
+            }
+            p = next;
+            consumed = static_cast<std::size_t>(p - start);
+        }
+        return DecodeStatus::End;
+    }
+
+    // Forgets the delta state, as a SYNC record does (after a seek).
+    void restart() {
+        prev_seq_ = 0;
+        prev_ts_ = 0;
+    }
+
+    // Where the event the last decode() returned starts, relative to its p
+    // (past any symbol, sync or filtered records in front of it).
+    std::size_t event_at() const { return event_at_; }
+
+    const std::vector<std::string>& symbols() const { return symbols_; }
+    void set_symbols(std::vector<std::string> syms) { symbols_ = std::move(syms); }
+    void set_checksums(bool on) { checksums_ = on; }
+
+    // Records rejected by pre are skipped without decoding their payload.
+    // pre must outlive the reader; nullptr turns it off.
+    void set_prefilter(const EventPrefilter* pre) { pre_ = pre; }
+    uint64_t filtered() const { return filtered_; }
+};
+
+}
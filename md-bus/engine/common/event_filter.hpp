@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "event.hpp"
+#include "event_io.hpp"
+
+namespace md {
+
+/*
+ * EventPrefilter
+ * --------------
+ * Time / topic / symbol filter that the readers apply to a record before
+ * its payload is decoded: text lines are judged on their raw ts, topic and
+ * symbol fields, binary records on their header and symbol id, columnar
+ * blocks on their ts, topic and symbol columns. A rejected record costs a
+ * field scan instead of number parsing and string copies.
+ *
+ * Topics are a bitmask (topic_bit). Symbols are a hash set; readers with a
+ * symbol table resolve each id against it once and keep the answer in a
+ * per-id table, so later records are a single lookup. With a symbol set
+ * only Tick events pass, as with ReplayFilter::symbol.
+ *
+ * Not thread-safe when by_symbol() (the id table fills in lazily); give
+ * each reader its own copy.
+ */
+class EventPrefilter {
+private :
+    uint64_t topics_{~0ull};
+    uint64_t ts_min_{0};
+    uint64_t ts_max_{UINT64_MAX};
+    bool by_symbol_{false};
+    std::unordered_set<std::string> symbols_;
+    mutable std::vector<uint8_t> by_id_;    // 0 unresolved, 1 rejected, 2 accepted
+public :
+    static constexpr uint64_t topic_bit(Topic t) { return 1ull << (static_cast<unsigned>(t) & 63); }
+
+    void set_topics(uint64_t mask) { topics_ = mask; }
+    void set_time_range(uint64_t ts_min, uint64_t ts_max) {
+        ts_min_ = ts_min;
+        ts_max_ = ts_max;
+    }
+    void add_symbol(std::string symbol) {
+        by_symbol_ = true;
+        symbols_.insert(std::move(symbol));
+        by_id_.clear();
+    }
+
+    bool active() const {
+        return topics_ != ~0ull || ts_min_ != 0 || ts_max_ != UINT64_MAX || by_symbol_;
+    }
+    bool by_symbol() const { return by_symbol_; }
+
+    bool admits_header(uint64_t ts_ns, Topic t) const {
+        return (topics_ & topic_bit(t)) != 0 && ts_ns >= ts_min_ && ts_ns <= ts_max_;
+    }
+
+    // std::string keys: short symbols fit the small-string buffer, so the
+    // temporary does not allocate.
+    bool admits_symbol(std::string_view symbol) const {
+        return symbols_.count(std::string(symbol)) > 0;
+    }
+
+    // Symbol id of a binary / columnar log, names being its symbol table.
+    bool admits_symbol_id(uint64_t id, const std::vector<std::string>& names) const {
+        if(id >= names.size()) return true; // let the decoder report it
+        if(by_id_.size() < names.size()) by_id_.resize(names.size(), 0);
+        uint8_t& s = by_id_[id];
+        if(s == 0) s = admits_symbol(names[id]) ? 2 : 1;
+        return s == 2;
+    }
+
+    // A whole text line. Lines whose header cannot be read pass, so that
+    // parse_event reports them.
+    bool admits_line(std::string_view line) const {
+        detail::FieldCursor c{line};
+        uint64_t ts = 0;
+        Topic t{};
+        c.field(',');
+        if(!c.number(',', ts) || !topic_from_string(c.field(','), t)) return true;
+        if(!admits_header(ts, t)) return false;
+        if(!by_symbol_) return true;
+        if(c.rest.rfind("TICK|", 0) != 0) return false;
+        c.rest.remove_prefix(5);
+        return admits_symbol(c.field('|'));
+    }
+
+    // A decoded event (for sources without pushdown).
+    bool admits(const Event& e) const {
+        if(!admits_header(e.h.ts_ns, e.h.topic)) return false;
+        if(!by_symbol_) return true;
+        const auto* t = std::get_if<Tick>(&e.p);
+        return t && admits_symbol(t->symbol);
+    }
+};
+
+}
@@ -0,0 +1,232 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "event.hpp"
+#include "event_binary.hpp"
+
+namespace md {
+
+// --- Sparse index sidecar (<log>.idx) ---
+//
+// The recorder cuts its log into blocks of block_events events and, for
+// every block, remembers the file offset where it starts, its ts range and
+// event count. For every symbol it keeps the sorted list of blocks that
+// contain it (a sparse per-symbol block bitmap). In binary logs each block
+// starts with a SYNC record, and in columnar logs index blocks are codec
+// blocks, so decoding can begin at any block offset given the symbol table
+// stored here.
+//
+// Symbol ids are assigned in first-seen order of payload_symbol(), the
+// same rule BinaryEventWriter uses, so they double as the binary log's ids.
+//
+// File layout (all integers varint unless noted):
+//   "MDIX" | u16 version | u8 format | block_events | data_bytes | n_blocks
+//   n_blocks x { offset | ts_min | ts_max | count }
+//   n_symbols x { name_len | name | n | delta-coded block ids }
+//
+// data_bytes is the log size covered by the index. Anything after it (the
+// index is rewritten on flush / close) is scanned without the index.
+
+inline constexpr char kIndexMagic[4] = {'M', 'D', 'I', 'X'};
+inline constexpr uint16_t kIndexVersion = 1;
+
+struct IndexBlock {
+    uint64_t offset{0};
+    uint64_t ts_min{UINT64_MAX};
+    uint64_t ts_max{0};
+    uint64_t count{0};
+};
+
+inline std::string index_path_for(const std::string& log_path) {
+    return log_path + ".idx";
+}
+
+class EventIndex {
+private :
+    RecordFormat format_{RecordFormat::Text};
+    uint64_t block_events_{0};
+    uint64_t data_bytes_{0};
+    std::vector<IndexBlock> blocks_;
+    std::vector<std::string> symbols_;
+    std::vector<std::vector<uint32_t>> symbol_blocks_;
+    std::unordered_map<std::string, uint32_t> symbol_ids_;
+
+    friend class EventIndexBuilder;
+public :
+    RecordFormat format() const { return format_; }
+    uint64_t block_events() const { return block_events_; }
+    uint64_t data_bytes() const { return data_bytes_; }
+    const std::vector<IndexBlock>& blocks() const { return blocks_; }
+    const std::vector<std::string>& symbols() const { return symbols_; }
+
+    // Byte offset one past block i.
+    uint64_t block_end(std::size_t i) const {
+        return i + 1 < blocks_.size() ? blocks_[i + 1].offset : data_bytes_;
+    }
+
+    // Blocks containing symbol, ascending; nullptr if it never appears.
+    const std::vector<uint32_t>* blocks_for_symbol(std::string_view symbol) const {
+        auto it = symbol_ids_.find(std::string(symbol));
+        return it == symbol_ids_.end() ? nullptr : &symbol_blocks_[it->second];
+    }
+
+    void serialize(std::string& out) const {
+        out.append(kIndexMagic, 4);
+        out.push_back(static_cast<char>(kIndexVersion & 0xff));
+        out.push_back(static_cast<char>(kIndexVersion >> 8));
+        out.push_back(static_cast<char>(format_));
+        put_varint(out, block_events_);
+        put_varint(out, data_bytes_);
+        put_varint(out, blocks_.size());
+        for(const auto& b : blocks_) {
+            put_varint(out, b.offset);
+            put_varint(out, b.ts_min);
+            put_varint(out, b.ts_max);
+            put_varint(out, b.count);
+        }
+        put_varint(out, symbols_.size());
+        for(std::size_t s = 0; s < symbols_.size(); ++s) {
+            put_varint(out, symbols_[s].size());
+            out.append(symbols_[s]);
+            const auto& ids = symbol_blocks_[s];
+            put_varint(out, ids.size());
+            uint32_t prev = 0;
+            for(uint32_t id : ids) {
+                put_varint(out, id - prev);
+                prev = id;
+            }
+        }
+    }
+
+    bool parse(std::string_view data) {
+        if(data.size() < 7 || std::memcmp(data.data(), kIndexMagic, 4) != 0) return false;
+        const auto* u = reinterpret_cast<const unsigned char*>(data.data());
+        if(static_cast<uint16_t>(u[4] | (u[5] << 8)) != kIndexVersion) return false;
+        if(u[6] > static_cast<unsigned char>(RecordFormat::Columnar)) return false;
+        format_ = static_cast<RecordFormat>(u[6]);
+        ByteCursor c{data.data() + 7, data.data() + data.size()};
+        block_events_ = c.varint();
+        data_bytes_ = c.varint();
+        const uint64_t nb = c.varint();
+        if(!c.ok || nb > data.size()) return false;
+        blocks_.resize(nb);
+        for(auto& b : blocks_) {
+            b.offset = c.varint();
+            b.ts_min = c.varint();
+            b.ts_max = c.varint();
+            b.count = c.varint();
+        }
+        const uint64_t ns = c.varint();
+        if(!c.ok || ns > data.size()) return false;
+        symbols_.resize(ns);
+        symbol_blocks_.resize(ns);
+        symbol_ids_.clear();
+        for(uint64_t s = 0; s < ns; ++s) {
+            symbols_[s] = std::string(c.bytes(c.varint()));
+            const uint64_t n = c.varint();
+            if(!c.ok || n > nb) return false;
+            auto& ids = symbol_blocks_[s];
+            ids.resize(n);
+            uint32_t prev = 0;
+            for(auto& id : ids) {
+                id = prev + static_cast<uint32_t>(c.varint());
+                prev = id;
+            }
+            symbol_ids_.emplace(symbols_[s], static_cast<uint32_t>(s));
+        }
+        return c.ok;
+    }
+
+    // Loads path's sidecar. False (and an empty index) when there is none,
+    // it is unreadable, or it claims more data than the log holds.
+    bool load_for(const std::string& log_path) {
+        std::ifstream in(index_path_for(log_path), std::ios::in | std::ios::binary);
+        if(!in) return false;
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::error_code ec;
+        const auto log_size = std::filesystem::file_size(log_path, ec);
+        if(ec || !parse(data) || data_bytes_ > log_size) {
+            *this = EventIndex{};
+            return false;
+        }
+        return true;
+    }
+
+    // Writes path's sidecar atomically (tmp file + rename).
+    bool save_for(const std::string& log_path) const {
+        std::string data;
+        serialize(data);
+        const std::string path = index_path_for(log_path);
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::out | std::ios::trunc | std::ios::binary);
+            if(!out) return false;
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if(!out) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        return !ec;
+    }
+};
+
+/*
+ * EventIndexBuilder
+ * -----------------
+ * Fed by the recorder in write order:
+ *   if(b.block_full()) { b.begin_block(offset); ...emit SYNC for binary... }
+ *   b.add(e);
+ *   ...append the encoded event...
+ *   b.set_data_bytes(offset_after);
+ */
+class EventIndexBuilder {
+private :
+    EventIndex idx_;
+public :
+    EventIndexBuilder(RecordFormat format, uint64_t block_events) {
+        idx_.format_ = format;
+        idx_.block_events_ = block_events;
+    }
+
+    bool block_full() const {
+        return idx_.blocks_.empty() || idx_.blocks_.back().count >= idx_.block_events_;
+    }
+
+    void begin_block(uint64_t offset) {
+        IndexBlock b;
+        b.offset = offset;
+        idx_.blocks_.push_back(b);
+    }
+
+    void add(const Event& e) {
+        auto& b = idx_.blocks_.back();
+        b.ts_min = std::min(b.ts_min, e.h.ts_ns);
+        b.ts_max = std::max(b.ts_max, e.h.ts_ns);
+        ++b.count;
+
+        const std::string* sym = payload_symbol(e.p);
+        if(!sym) return;
+        const auto block = static_cast<uint32_t>(idx_.blocks_.size() - 1);
+        auto [it, inserted] = idx_.symbol_ids_.try_emplace(*sym, static_cast<uint32_t>(idx_.symbols_.size()));
+        if(inserted) {
+            idx_.symbols_.push_back(*sym);
+            idx_.symbol_blocks_.emplace_back();
+        }
+        auto& ids = idx_.symbol_blocks_[it->second];
+        if(ids.empty() || ids.back() != block) ids.push_back(block);
+    }
+
+    void set_data_bytes(uint64_t n) { idx_.data_bytes_ = n; }
+
+    const EventIndex& index() const { return idx_; }
+};
+
+}
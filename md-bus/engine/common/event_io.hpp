@@ -1,8 +1,12 @@
 #pragma once 
+#include <charconv>
 #include <string>
 #include <string_view>
 #include <variant>
 
+#include <fmt/format.h>
+
+#include "byte_scan.hpp"
 #include "event.hpp"
 
 namespace md {
@@ -15,6 +19,8 @@ inline std::string to_string(Topic t){
         case Topic::HEARTBEAT : return "HEARTBEAT";
         case Topic::BAR_1S : return "BAR_1S";
         case Topic::BAR_1M : return "BAR_1M";
+        case Topic::BAR_5M : return "BAR_5M";
+        case Topic::BAR_CUSTOM : return "BAR_CUSTOM";
     }
     return "UNKNOWN";
 }
@@ -26,6 +32,8 @@ inline bool topic_from_string(std::string_view s, Topic& out){
     if(s == "HEARTBEAT") {out = Topic::HEARTBEAT; return true;}
     if(s == "BAR_1S") {out = Topic::BAR_1S; return true;}
     if(s == "BAR_1M") {out = Topic::BAR_1M; return true;}
+    if(s == "BAR_5M") {out = Topic::BAR_5M; return true;}
+    if(s == "BAR_CUSTOM") {out = Topic::BAR_CUSTOM; return true;}
     return false;
 }
 
@@ -34,35 +42,72 @@ inline bool topic_from_string(std::string_view s, Topic& out){
 //   monostate: "-"
 //   Tick:      "TICK|<symbol>|<pq>|<qty>"
 //   Log:       "LOG|<text>"
+//   Bar:       "BAR|<symbol>|<open>|<high>|<low>|<close>|<volume>|<start_ts_ns>|<end_ts_ns>"
 // (We assume log text doesn’t contain newlines or '|'; fine for now.)
+// Doubles are written in shortest round-trip form, so parse(serialize(x)) == x.
 
-inline std::string serialize_payload(const Payload& p){
+inline void append_double(std::string& s, double v){
+    fmt::format_to(std::back_inserter(s), "{}", v);
+}
+
+template <typename Int>
+inline void append_int(std::string& s, Int v){
+    fmt::format_int f(v);
+    s.append(f.data(), f.size());
+}
+
+// Appends the payload text to s (no allocation beyond s growing).
+inline void append_payload(std::string& s, const Payload& p){
     if(std::holds_alternative<std::monostate>(p)){
-        return "-";
+        s.push_back('-');
+        return;
     }
 
     if(std::holds_alternative<Tick>(p)){
         const auto& t = std::get<Tick>(p);
-        std::string s;
-        s.reserve(64);
         s.append("TICK|");
         s.append(t.symbol);
         s.push_back('|');
-        s.append(std::to_string(t.pq));
+        append_double(s, t.pq);
         s.push_back('|');
-        s.append(std::to_string(t.qty));
-        return s;
+        append_int(s, t.qty);
+        return;
+    }
+
+    if(std::holds_alternative<Bar>(p)){
+        const auto& b = std::get<Bar>(p);
+        s.append("BAR|");
+        s.append(b.symbol);
+        s.push_back('|');
+        append_double(s, b.open);
+        s.push_back('|');
+        append_double(s, b.high);
+        s.push_back('|');
+        append_double(s, b.low);
+        s.push_back('|');
+        append_double(s, b.close);
+        s.push_back('|');
+        append_int(s, b.volume);
+        s.push_back('|');
+        append_int(s, b.start_ts_ns);
+        s.push_back('|');
+        append_int(s, b.end_ts_ns);
+        return;
     }
 
     if(std::holds_alternative<std::string>(p)){
-        const auto& msg = std::get<std::string>(p);
-        std::string s;
-        s.reserve(16 + msg.size());
         s.append("LOG|");
-        s.append(msg);
-        return s;
+        s.append(std::get<std::string>(p));
+        return;
     }
-    return "UNKNOWN";
+    s.append("UNKNOWN");
+}
+
+inline std::string serialize_payload(const Payload& p){
+    std::string s;
+    s.reserve(64);
+    append_payload(s, p);
+    return s;
 }
 
 // --- Event serialization ---
@@ -71,91 +116,103 @@ inline std::string serialize_payload(const Payload& p){
 // Example:
 //   0,1234567890,MD_TICK,TICK|NIFTY|22500.0|100
 
-inline std::string serialize_event(const Event& e){
-    std::string s;
-    s.reserve(128);
-
-    s.append(std::to_string(e.h.seq));
+// Appends one line (without the trailing newline) to s.
+inline void append_event(std::string& s, const Event& e){
+    append_int(s, e.h.seq);
     s.push_back(',');
-    s.append(std::to_string(e.h.ts_ns));
+    append_int(s, e.h.ts_ns);
     s.push_back(',');
     s.append(to_string(e.h.topic));
     s.push_back(',');
-    s.append(serialize_payload(e.p));
+    append_payload(s, e.p);
+}
+
+inline std::string serialize_event(const Event& e){
+    std::string s;
+    s.reserve(128);
+    append_event(s, e);
     return s;
 }
 
-//parsing helpers 
-//reconstructing Event from string line
-
-// splits string_view by delim into vector of string_views
-// string_view is a non-owning view (pointer + length) into existing string data,
-// used here to avoid copying substrings.
-
-inline std::vector<std::string_view> split_sv(std::string_view s, char delim) {
-    std::vector<std::string_view> out ;
-    size_t start = 0;
-    while(start <= s.size()){
-        size_t pos = s.find(delim, start);
-        if(pos == std::string_view::npos){
-            out.emplace_back(s.substr(start));
-            break;
-        }
-        //pos - start due to substr second arg being length
-        out.emplace_back(s.substr(start, pos - start));
-        start = pos + 1;
+// --- Parsing ---
+// One pass over the line with std::from_chars: no exceptions and no heap
+// allocation beyond strings already held by out (Event objects reused
+// across lines keep their symbol / text capacity).
+
+namespace detail {
+
+// Cuts delimited fields off the front of a string_view.
+struct FieldCursor {
+    std::string_view rest;
+
+    // Next field up to delim (consumed) or to the end.
+    std::string_view field(char delim) {
+        const size_t pos = find_byte(rest, delim);
+        std::string_view f = rest.substr(0, pos);
+        rest = pos == std::string_view::npos ? std::string_view{} : rest.substr(pos + 1);
+        return f;
+    }
+
+    template <typename T>
+    bool number(char delim, T& out) {
+        const std::string_view f = field(delim);
+        const char* end = f.data() + f.size();
+        auto [ptr, ec] = std::from_chars(f.data(), end, out);
+        return ec == std::errc{} && ptr == end && !f.empty();
     }
-    return out ;
+};
+
 }
 
-// reconstruct Payload from string_view
-inline Payload parse_payload(std::string_view s) {
-    if(s == "-" || s.empty()) return  std::monostate{};
+// Fills out from the payload text; false if a TICK / BAR is malformed.
+// Unknown prefixes are kept as log text.
+inline bool parse_payload(std::string_view s, Payload& out) {
+    if(s == "-" || s.empty()) {
+        out = std::monostate{};
+        return true;
+    }
     if(s.rfind("TICK|", 0) == 0) {
-        auto rest = s.substr(5);
-        auto parts = split_sv(rest, '|');
-        if(parts.size() < 3){
-            return std::monostate{};
-        }
-        Tick t;
-        t.symbol = std::string(parts[0]);
-        try{
-            t.pq = std::stod(std::string(parts[1]));
-            t.qty = static_cast<uint32_t>(std::stoul(std::string(parts[2])));
-        }catch(...) {
-            return std::monostate{};
-        }
-        return t;
+        detail::FieldCursor c{s.substr(5)};
+        Tick& t = emplace_reuse<Tick>(out);
+        const std::string_view sym = c.field('|');
+        t.symbol.assign(sym.data(), sym.size());
+        return c.number('|', t.pq) && c.number('|', t.qty);
     }
-
-    if(s.rfind("LOG|", 0) == 0){
-        auto msg = s.substr(4);
-        return std::string(msg);
+    if(s.rfind("BAR|", 0) == 0) {
+        detail::FieldCursor c{s.substr(4)};
+        Bar& b = emplace_reuse<Bar>(out);
+        const std::string_view sym = c.field('|');
+        b.symbol.assign(sym.data(), sym.size());
+        return c.number('|', b.open) && c.number('|', b.high) &&
+               c.number('|', b.low) && c.number('|', b.close) &&
+               c.number('|', b.volume) && c.number('|', b.start_ts_ns) &&
+               c.number('|', b.end_ts_ns);
     }
-    return std::string(s);
+    if(s.rfind("LOG|", 0) == 0) s.remove_prefix(4);
+    emplace_reuse<std::string>(out).assign(s.data(), s.size());
+    return true;
 }
 
-inline bool parse_event(std::string_view line, Event& out) {
-    auto parts = split_sv(line, ',');
-    if(parts.size() < 4){
-        return false;
-    }
+// Malformed payloads come back as monostate.
+inline Payload parse_payload(std::string_view s) {
+    Payload p;
+    if(!parse_payload(s, p)) return std::monostate{};
+    return p;
+}
 
-    try {
-        out.h.seq = static_cast<uint64_t>(std::stoull(std::string(parts[0])));
-        out.h.ts_ns = static_cast<uint64_t>(std::stoull(std::string(parts[1])));
-    } catch (...) { // catch all handler 
+// seq,ts_ns,topic,payload -- the payload is the rest of the line, so log
+// text may contain commas.
+inline bool parse_event(std::string_view line, Event& out) {
+    detail::FieldCursor c{line};
+    if(!c.number(',', out.h.seq) || !c.number(',', out.h.ts_ns)) {
         return false;
     }
-
-    Topic t;
-    if(!topic_from_string(parts[2], t)) {
+    const size_t comma = find_byte(c.rest, ',');
+    if(comma == std::string_view::npos || !topic_from_string(c.rest.substr(0, comma), out.h.topic)) {
         return false;
     }
-    out.h.topic = t;
-
-    out.p = parse_payload(parts[3]);
-    return true;
+    c.rest.remove_prefix(comma + 1);
+    return parse_payload(c.rest, out.p);
 }
 
-}
\ No newline at end of file
+}
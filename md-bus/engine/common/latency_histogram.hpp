@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace md {
+
+// Lock-free log-linear histogram of nanosecond durations.
+// Each power of two is split into 8 linear sub-buckets, so any reported
+// percentile is within ~12.5% of the true value. record() is a couple of
+// relaxed atomic increments and is safe to call from any thread.
+class LatencyHistogram {
+private :
+    static constexpr int kSubBits = 3;
+    static constexpr uint64_t kSub = 1ULL << kSubBits;
+    static constexpr std::size_t kBuckets = (64 - kSubBits + 1) * kSub;
+
+    std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+
+    static std::size_t index_of(uint64_t v) {
+        if(v < kSub) return static_cast<std::size_t>(v);
+        const int msb = 63 - __builtin_clzll(v);
+        return static_cast<std::size_t>((msb - kSubBits + 1) * kSub +
+                                        ((v >> (msb - kSubBits)) & (kSub - 1)));
+    }
+
+    // smallest value that lands in bucket idx
+    static uint64_t lower_bound_of(std::size_t idx) {
+        if(idx < kSub) return idx;
+        const int msb = static_cast<int>(idx / kSub) + kSubBits - 1;
+        return (kSub + idx % kSub) << (msb - kSubBits);
+    }
+public :
+    void record(uint64_t ns) {
+        buckets_[index_of(ns)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t prev = max_ns_.load(std::memory_order_relaxed);
+        while(ns > prev &&
+              !max_ns_.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_ns_.load(std::memory_order_relaxed); }
+    uint64_t mean() const {
+        const uint64_t n = count();
+        return n ? sum_ns_.load(std::memory_order_relaxed) / n : 0;
+    }
+
+    // q in [0, 1]; returns the upper edge of the bucket holding that rank
+    uint64_t percentile(double q) const {
+        const uint64_t n = count();
+        if(n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n));
+        if(rank >= n) rank = n - 1;
+        uint64_t seen = 0;
+        for(std::size_t i = 0; i < kBuckets; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if(seen > rank) {
+                const uint64_t hi = (i + 1 < kBuckets) ? lower_bound_of(i + 1) - 1 : UINT64_MAX;
+                return hi < max() ? hi : max();
+            }
+        }
+        return max();
+    }
+};
+
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include <fmt/core.h>
+#include <fmt/format.h>
+#include <cstdio>
+#include <iterator>
 #include <string_view> 
 #include <chrono>
 #include <thread>
@@ -7,6 +10,8 @@
 #include <mutex>
 #include <functional> 
 
+#include "async_log.hpp"
+
 namespace md {
 enum class LogLevel {
     Debug,
@@ -35,6 +40,21 @@ inline LogLevel& global_log_level() {
     return lvl;
 }
 
+// Compile-time floor for logging: 0 = Debug, 1 = Info, 2 = Warn, 3 = Error.
+// Set by the build (MD_LOG_LEVEL in engine/CMakeLists.txt); anything below it
+// is compiled out, whatever global_log_level() says at runtime.
+#ifndef MD_LOG_MIN_LEVEL
+#define MD_LOG_MIN_LEVEL 0
+#endif
+
+constexpr bool log_compiled_in(LogLevel lvl) {
+    return static_cast<int>(lvl) >= MD_LOG_MIN_LEVEL;
+}
+
+inline bool log_enabled(LogLevel lvl) {
+    return static_cast<int>(lvl) >= static_cast<int>(global_log_level());
+}
+
 
 //the goal is to print a log message with log level and a format string
 //And any number of extra arguments(of anytype)
@@ -52,11 +72,18 @@ inline LogLevel& global_log_level() {
 //i.e && gives you ability to avoid copies and forward Lets you avoid extra copies
 
 template <typename... Args> //... is to tell Args is pack of types
-inline void log(LogLevel lvl, std::string_view fmt_str, Args&&... args){
+inline void log(LogLevel lvl, fmt::format_string<Args...> fmt_str, Args&&... args){
     if(static_cast<int>(lvl) < static_cast<int>(global_log_level())){
         return;
     }
 
+    // hot path: hand the record to the background logger (see async_log.hpp)
+    if(detail::async_log_on()){
+        const fmt::string_view sv = fmt_str;
+        detail::log_async(lvl, std::string_view(sv.data(), sv.size()), args...);
+        return;
+    }
+
     using namespace std::chrono;
     auto now = system_clock::now();
     auto ms_since_epoch = duration_cast<milliseconds>(now.time_since_epoch()).count();
@@ -64,38 +91,67 @@ inline void log(LogLevel lvl, std::string_view fmt_str, Args&&... args){
     auto tid = std::this_thread::get_id();
     auto tid_hash = static_cast<unsigned long long>(std::hash<std::thread::id>{}(tid));
 
-    std::scoped_lock lk(log_mutex());
-
-    fmt::print("[{}] t = {}ms tid = {} ",
-                to_string(lvl),
-                ms_since_epoch,
-                tid_hash);
-    
-    fmt::print(fmt_str, std::forward<Args>(args)...); //... here acts as expanding pack
-    fmt::print("\n");
+    // format the whole line first, then one write under the lock
+    fmt::memory_buffer buf;
+    fmt::format_to(std::back_inserter(buf), "[{}] t = {}ms tid = {} ",
+                   to_string(lvl),
+                   ms_since_epoch,
+                   tid_hash);
+    fmt::format_to(std::back_inserter(buf), fmt_str, std::forward<Args>(args)...); //... here acts as expanding pack
+    buf.push_back('\n');
 
+    std::scoped_lock lk(log_mutex());
+    std::fwrite(buf.data(), 1, buf.size(), stdout);
 }
 
 // Convenience wrappers 
 //calling log function that we defines above
+//Levels below MD_LOG_MIN_LEVEL are discarded at compile time: the wrapper
+//body is an empty if constexpr branch.
 template<typename... Args>
-inline void log_debug(std::string_view fmt_str, Args&&... args){
-    log(LogLevel::Debug, fmt_str, std::forward<Args>(args)...);
+inline void log_debug(fmt::format_string<Args...> fmt_str, Args&&... args){
+    if constexpr (log_compiled_in(LogLevel::Debug)) {
+        log(LogLevel::Debug, fmt_str, std::forward<Args>(args)...);
+    }
 }
 
 template<typename... Args>
-inline void log_info(std::string_view fmt_str, Args&&... args){
-    log(LogLevel::Info, fmt_str, std::forward<Args>(args)...);
+inline void log_info(fmt::format_string<Args...> fmt_str, Args&&... args){
+    if constexpr (log_compiled_in(LogLevel::Info)) {
+        log(LogLevel::Info, fmt_str, std::forward<Args>(args)...);
+    }
 }
 
 template<typename... Args>
-inline void log_warn(std::string_view fmt_str, Args&&... args){
-    log(LogLevel::Warn, fmt_str, std::forward<Args>(args)...);
+inline void log_warn(fmt::format_string<Args...> fmt_str, Args&&... args){
+    if constexpr (log_compiled_in(LogLevel::Warn)) {
+        log(LogLevel::Warn, fmt_str, std::forward<Args>(args)...);
+    }
 }
 
 template<typename... Args>
-inline void log_error(std::string_view fmt_str, Args&&... args){
-    log(LogLevel::Error, fmt_str, std::forward<Args>(args)...);
+inline void log_error(fmt::format_string<Args...> fmt_str, Args&&... args){
+    if constexpr (log_compiled_in(LogLevel::Error)) {
+        log(LogLevel::Error, fmt_str, std::forward<Args>(args)...);
+    }
+}
+
 }
 
-}
\ No newline at end of file
+// Call-site macros for per-event logging.
+// Unlike the functions above, the arguments are only evaluated when the level
+// is both compiled in and enabled at runtime, and the format string is checked
+// against the arguments at compile time (FMT_STRING) even under C++17.
+#define MD_LOG_AT(lvl, fmt_str, ...)                                              \
+    do {                                                                          \
+        if constexpr (::md::log_compiled_in(lvl)) {                               \
+            if (::md::log_enabled(lvl)) {                                         \
+                ::md::log(lvl, FMT_STRING(fmt_str), ##__VA_ARGS__);               \
+            }                                                                     \
+        }                                                                         \
+    } while (0)
+
+#define MD_LOG_DEBUG(fmt_str, ...) MD_LOG_AT(::md::LogLevel::Debug, fmt_str, ##__VA_ARGS__)
+#define MD_LOG_INFO(fmt_str, ...)  MD_LOG_AT(::md::LogLevel::Info,  fmt_str, ##__VA_ARGS__)
+#define MD_LOG_WARN(fmt_str, ...)  MD_LOG_AT(::md::LogLevel::Warn,  fmt_str, ##__VA_ARGS__)
+#define MD_LOG_ERROR(fmt_str, ...) MD_LOG_AT(::md::LogLevel::Error, fmt_str, ##__VA_ARGS__)
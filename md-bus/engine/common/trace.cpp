@@ -0,0 +1,242 @@
+#include "trace.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "log.hpp"
+
+namespace md::trace {
+
+namespace {
+
+struct SpanRec {
+    const char* name;
+    const char* cat;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    uint64_t seq;
+};
+
+// Spans live in fixed-size chunks so the owner thread never reallocates
+// memory a concurrent dump might be reading. count is published with
+// release order after the span is written.
+struct Chunk {
+    static constexpr std::size_t kSpans = 4096;
+    SpanRec spans[kSpans];
+    std::atomic<uint32_t> count{0};
+    std::atomic<Chunk*> next{nullptr};
+};
+
+struct ThreadBuffer {
+    uint32_t tid{0};
+    std::string name;               // guarded by Registry::mu
+    Chunk* head{nullptr};
+    Chunk* tail{nullptr};
+    std::size_t total{0};
+    std::atomic<uint64_t> dropped{0};
+
+    ~ThreadBuffer() {
+        Chunk* c = head;
+        while(c) {
+            Chunk* n = c->next.load(std::memory_order_relaxed);
+            delete c;
+            c = n;
+        }
+    }
+};
+
+struct Registry {
+    std::mutex mu;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::string path;
+    std::size_t max_spans{0};
+    uint64_t start_ns{0};
+    std::atomic<uint64_t> generation{1};
+    uint32_t next_tid{1};
+};
+
+// intentionally leaked: must outlive thread_local buffers and the
+// exit-time dump below
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+struct LocalSlot {
+    std::shared_ptr<ThreadBuffer> buf;
+    uint64_t generation{0};
+    std::string name;
+};
+
+LocalSlot& local_slot() {
+    thread_local LocalSlot slot;
+    return slot;
+}
+
+ThreadBuffer& local_buffer() {
+    auto& slot = local_slot();
+    auto& reg = registry();
+    const uint64_t gen = reg.generation.load(std::memory_order_acquire);
+    if(!slot.buf || slot.generation != gen) {
+        auto b = std::make_shared<ThreadBuffer>();
+        b->head = b->tail = new Chunk;
+        std::scoped_lock lk(reg.mu);
+        b->tid = reg.next_tid++;
+        b->name = slot.name;
+        reg.buffers.push_back(b);
+        slot.buf = std::move(b);
+        slot.generation = gen;
+    }
+    return *slot.buf;
+}
+
+void write_escaped(std::FILE* f, const char* s) {
+    for(; *s; ++s) {
+        if(*s == '"' || *s == '\\') std::fputc('\\', f);
+        std::fputc(*s, f);
+    }
+}
+
+// Enables tracing for the whole process when MD_TRACE_FILE is set, and
+// dumps whatever was collected at exit.
+struct AutoStart {
+    AutoStart() {
+        if(const char* p = std::getenv("MD_TRACE_FILE"); p && *p) {
+            start(p);
+        }
+    }
+    ~AutoStart() {
+        if(enabled()) stop();
+    }
+};
+AutoStart auto_start;
+
+}
+
+void start(const std::string& path, std::size_t max_spans_per_thread) {
+    auto& reg = registry();
+    {
+        std::scoped_lock lk(reg.mu);
+        reg.buffers.clear();
+        reg.path = path;
+        reg.max_spans = max_spans_per_thread;
+        reg.start_ns = now_ns();
+        reg.generation.fetch_add(1, std::memory_order_release);
+    }
+    enabled_flag().store(true, std::memory_order_release);
+    log_info("trace: recording spans (max {} per thread) -> '{}'", max_spans_per_thread, path);
+}
+
+void set_thread_name(const std::string& name) {
+    local_slot().name = name;
+    if(!enabled()) return;
+    auto& b = local_buffer();
+    std::scoped_lock lk(registry().mu);
+    b.name = name;
+}
+
+void record(const char* name, const char* cat, uint64_t start_ns, uint64_t end_ns,
+            uint64_t seq) {
+    if(!enabled()) return;
+    auto& b = local_buffer();
+    if(b.total >= registry().max_spans) {
+        b.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Chunk* c = b.tail;
+    uint32_t n = c->count.load(std::memory_order_relaxed);
+    if(n == Chunk::kSpans) {
+        Chunk* fresh = new Chunk;
+        c->next.store(fresh, std::memory_order_release);
+        b.tail = c = fresh;
+        n = 0;
+    }
+    c->spans[n] = SpanRec{name, cat, start_ns, end_ns, seq};
+    c->count.store(n + 1, std::memory_order_release);
+    ++b.total;
+}
+
+bool stop() {
+    if(!enabled_flag().exchange(false)) return true;
+
+    auto& reg = registry();
+    std::scoped_lock lk(reg.mu);
+
+    std::FILE* f = std::fopen(reg.path.c_str(), "w");
+    if(!f) {
+        log_error("trace: failed to open '{}'", reg.path);
+        reg.buffers.clear();
+        reg.generation.fetch_add(1, std::memory_order_release);
+        return false;
+    }
+
+    auto rel_us = [&](uint64_t ns) {
+        return ns >= reg.start_ns ? static_cast<double>(ns - reg.start_ns) / 1000.0 : 0.0;
+    };
+
+    std::size_t spans = 0;
+    uint64_t dropped = 0;
+    bool first = true;
+    auto sep = [&] {
+        std::fputs(first ? "\n" : ",\n", f);
+        first = false;
+    };
+
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f);
+    for(const auto& b : reg.buffers) {
+        if(!b->name.empty()) {
+            sep();
+            fmt::print(f, "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"", b->tid);
+            write_escaped(f, b->name.c_str());
+            std::fputs("\"}}", f);
+        }
+        dropped += b->dropped.load(std::memory_order_relaxed);
+
+        for(Chunk* c = b->head; c; c = c->next.load(std::memory_order_acquire)) {
+            const uint32_t n = c->count.load(std::memory_order_acquire);
+            for(uint32_t i = 0; i < n; ++i) {
+                const SpanRec& s = c->spans[i];
+                const double ts = rel_us(s.start_ns);
+                const double dur = static_cast<double>(s.end_ns - s.start_ns) / 1000.0;
+                sep();
+                std::fputs("{\"name\":\"", f);
+                write_escaped(f, s.name);
+                std::fputs("\",\"cat\":\"", f);
+                write_escaped(f, s.cat);
+                fmt::print(f, "\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}",
+                           b->tid, ts, dur);
+                if(s.seq != kNoSeq) {
+                    fmt::print(f, ",\"args\":{{\"seq\":{}}}}}", s.seq);
+                    // flow arrow: starts at the publish span, steps through
+                    // routing and every subscriber callback of the same seq
+                    const bool origin = std::string_view(s.name) == "publish";
+                    sep();
+                    fmt::print(f, "{{\"name\":\"event\",\"cat\":\"flow\",\"ph\":\"{}\",\"bp\":\"e\","
+                                  "\"id\":{},\"pid\":1,\"tid\":{},\"ts\":{:.3f}}}",
+                               origin ? "s" : "t", s.seq, b->tid, ts);
+                } else {
+                    std::fputs("}", f);
+                }
+                ++spans;
+            }
+        }
+    }
+    std::fputs("\n]}\n", f);
+    const bool ok = std::fclose(f) == 0;
+
+    log_info("trace: wrote {} spans from {} threads to '{}' (dropped {})",
+             spans, reg.buffers.size(), reg.path, dropped);
+
+    reg.buffers.clear();
+    reg.generation.fetch_add(1, std::memory_order_release);
+    return ok;
+}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "event.hpp"
+
+/*
+ * Event-flow tracing (Chrome / Perfetto trace JSON)
+ * -------------------------------------------------
+ * Opt-in: nothing is recorded until trace::start() is called, or the
+ * MD_TRACE_FILE environment variable is set when the process starts.
+ * Each thread appends complete spans into its own chunked buffer (no locks
+ * on the hot path); trace::stop() - or process exit - writes them out as
+ * Chrome trace JSON, loadable in chrome://tracing or ui.perfetto.dev.
+ *
+ * Spans carrying an event seq are linked with flow arrows, so one event can
+ * be followed from publish -> reactor -> subscriber callback.
+ *
+ * Instrumentation uses MD_TRACE_SCOPE, which compiles away entirely when the
+ * engine is configured with -DMD_ENABLE_TRACE=OFF.
+ */
+
+namespace md::trace {
+
+inline constexpr uint64_t kNoSeq = UINT64_MAX;
+
+inline std::atomic<bool>& enabled_flag() {
+    static std::atomic<bool> on{false};
+    return on;
+}
+
+inline bool enabled() {
+    return enabled_flag().load(std::memory_order_relaxed);
+}
+
+// Starts collecting spans; stop() writes them to path.
+void start(const std::string& path, std::size_t max_spans_per_thread = 1u << 20);
+
+// Stops collecting and writes the JSON file. Call after the bus has been
+// stopped so that no thread is still appending. Returns false on I/O error.
+bool stop();
+
+// Names the calling thread in the trace viewer.
+void set_thread_name(const std::string& name);
+
+// Appends one complete span for the calling thread.
+void record(const char* name, const char* cat, uint64_t start_ns, uint64_t end_ns,
+            uint64_t seq);
+
+// RAII span: measures from construction to destruction.
+// name / cat must be string literals (only the pointer is stored).
+class TraceScope {
+private :
+    const char* name_;
+    const char* cat_;
+    uint64_t seq_;
+    uint64_t start_ns_;
+public :
+    TraceScope(const char* name, const char* cat, uint64_t seq = kNoSeq)
+        : name_{name}, cat_{cat}, seq_{seq},
+          start_ns_{enabled() ? now_ns() : 0} {}
+
+    ~TraceScope() {
+        if(start_ns_ != 0) {
+            record(name_, cat_, start_ns_, now_ns(), seq_);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+}
+
+#define MD_TRACE_CONCAT_INNER(a, b) a##b
+#define MD_TRACE_CONCAT(a, b) MD_TRACE_CONCAT_INNER(a, b)
+
+#ifdef MD_TRACE
+#define MD_TRACE_SCOPE(...) \
+    ::md::trace::TraceScope MD_TRACE_CONCAT(md_trace_scope_, __LINE__)(__VA_ARGS__)
+#define MD_TRACE_THREAD_NAME(name) ::md::trace::set_thread_name(name)
+#else
+#define MD_TRACE_SCOPE(...) ((void)0)
+#define MD_TRACE_THREAD_NAME(name) ((void)0)
+#endif
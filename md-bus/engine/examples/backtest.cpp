@@ -0,0 +1,50 @@
+#include <string>
+#include <fmt/core.h>
+#include "../common/event.hpp"
+#include "../common/log.hpp"
+#include "../replay/replay.hpp"
+
+#include "../strategy/accounting.hpp"
+#include "../strategy/backtest.hpp"
+#include "../strategy/bar_momentum.hpp"
+
+// The bar_momentum example without the bus: ticks are read, aggregated into
+// 1s bars and handed to the strategy on this thread, so no sleeps are needed
+// and every run produces the same trades.
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "logs/md_events.log";
+    std::string symbol = argc > 2 ? argv[2] : "NIFTY";
+
+    md::Account acct_bar;
+    md::BarMomentumStrategy strat_bar(
+        acct_bar,
+        symbol,
+        1,      // number of bars in the window
+        0.1,    // minimal momentum to enter long
+        1       // position size
+    );
+
+    md::BacktestConfig cfg;
+    cfg.filter.add_topic(md::Topic::MD_TICK);
+    if(argc > 3) {
+        // e.g. "cache/": the first run decodes the log into a dataset
+        // cache there, later runs read the cached columns
+        cfg.use_cache = true;
+        cfg.cache_dir = argv[3];
+    }
+
+    md::BacktestDriver bt(path, cfg);
+    bt.add_strategy(&strat_bar);
+    const md::BacktestStats stats = bt.run();
+
+    fmt::print("[BACKTEST] events={} ticks={} bars={} elapsed={:.3f} ms\n",
+               stats.events, stats.ticks, stats.bars, stats.elapsed_ns / 1e6);
+
+    fmt::print("\n=== BarMomentum Strategy Account Summary ===\n");
+    acct_bar.print_summary();
+
+    const std::string csv_name = "trades_backtest.csv";
+    acct_bar.dump_trades_csv(csv_name);
+    fmt::print("[INFO] dumped bar-momentum trades to '{}'\n", csv_name);
+    return 0;
+}
@@ -1,29 +1,71 @@
 #include <fmt/core.h>
 
-#include <fstream>
+#include <chrono>
+#include <cstdlib>
 #include <string>
+#include <string_view>
 #include <limits>
 
 #include "../common/event.hpp"
-#include "../common/event_io.hpp"
+#include "../common/event_index.hpp"
+#include "../replay/event_reader.hpp"
+#include "../replay/replay.hpp"
+
+// Usage: example_check_log [path] [--symbol SYM] [--from TS_NS] [--to TS_NS]
+//
+// Without filters the whole log is checked for parse errors and timestamp
+// order. With filters it only counts the matching events, using the .idx
+// sidecar to skip blocks when one is present.
+
+static int count_matches(const std::string& path, const md::ReplayFilter& f) {
+    md::EventIndex idx;
+    const bool indexed = idx.load_for(path);
+    const auto t0 = std::chrono::steady_clock::now();
+    const uint64_t n = md::scan_events(path, f, [](md::Event&) { return true; });
+    const double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+    fmt::print("[CHECK] '{}': {} matching events in {:.2f} ms ({})\n", path, n, ms,
+               indexed ? fmt::format("index: {} blocks", idx.blocks().size()) : "no index");
+    return 0;
+}
 
 int main (int argc, char ** argv){
     std::string path = "logs/md_events.log";
-    if(argc > 1) {
-        path = argv[1];
+    md::ReplayFilter filter;
+    for(int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if(arg == "--symbol" && has_value) {
+            filter.filter_by_symbol = true;
+            filter.symbol = argv[++i];
+        } else if(arg == "--from" && has_value) {
+            filter.filter_by_time = true;
+            filter.ts_min = std::strtoull(argv[++i], nullptr, 10);
+        } else if(arg == "--to" && has_value) {
+            filter.filter_by_time = true;
+            filter.ts_max = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            path = argv[i];
+        }
+    }
+    if(filter.filter_by_symbol || filter.filter_by_time) {
+        return count_matches(path, filter);
     }
-    std::ifstream in(path);
-    if(!in){
+
+    md::EventFileReader in(path);
+    if(!in.ok()){
         fmt::print("[CHECK ] failed to open log file '{}'\n", path);
         return 1;
     }
 
-    fmt::print("[CHECK ] Analysis log file '{}'\n", path);
+    fmt::print("[CHECK ] Analysis log file '{}' ({})\n", path,
+               md::to_string(in.format()));
+
+    in.set_error_handler([](uint64_t record_no, std::string_view raw) {
+        fmt::print("[CHECK] Parse error at record {}: '{}'\n", record_no, raw);
+    });
 
-    std::string line;
-    uint64_t line_no         = 0;
     uint64_t total_events    = 0;
-    uint64_t parse_errors    = 0;
     uint64_t backwards_count = 0;
     
     uint64_t prev_ts         = 0;
@@ -32,17 +74,8 @@ int main (int argc, char ** argv){
     int64_t min_dt_ns        = std::numeric_limits<int64_t>::max();
     int64_t max_dt_ns        = std::numeric_limits<int64_t>::min();
 
-    while (std::getline(in, line)) {
-        ++line_no;
-        if (line.empty()) continue;
-
-        md::Event e;
-        if (!md::parse_event(line, e)) {
-            ++parse_errors;
-            fmt::print("[CHECK] Parse error at line {}: '{}'\n", line_no, line);
-            continue;
-        }
-
+    md::Event e;
+    while (in.next(e)) {
         ++total_events;
 
         if (first_event) {
@@ -54,8 +87,8 @@ int main (int argc, char ** argv){
         int64_t dt_ns = static_cast<int64_t>(e.h.ts_ns) - static_cast<int64_t>(prev_ts);
         if (dt_ns < 0) {
             ++backwards_count;
-            fmt::print("[CHECK] Timestamp went backwards at line {}: ts={} prev_ts={}\n",
-                       line_no, e.h.ts_ns, prev_ts);
+            fmt::print("[CHECK] Timestamp went backwards at record {}: ts={} prev_ts={}\n",
+                       in.records(), e.h.ts_ns, prev_ts);
         }
 
         if (dt_ns < min_dt_ns) min_dt_ns = dt_ns;
@@ -66,7 +99,7 @@ int main (int argc, char ** argv){
 
     fmt::print("\n[CHECK] Summary for '{}':\n", path);
     fmt::print("  total_events     = {}\n", total_events);
-    fmt::print("  parse_errors     = {}\n", parse_errors);
+    fmt::print("  parse_errors     = {}\n", in.parse_errors());
     fmt::print("  backwards_count  = {}\n", backwards_count);
 
     if (!first_event && total_events > 1) {
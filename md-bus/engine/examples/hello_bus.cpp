@@ -1,5 +1,6 @@
 // engine/examples/hello_bus.cpp
 #include <fmt/core.h>
+#include <cmath>
 
 #include "../bus/bus.hpp"
 #include "../common/event.hpp"
@@ -17,6 +17,9 @@
 int main() {
     using namespace std::chrono_literals;
 
+    // keep BarBuilder / Account logging off the event threads
+    md::start_async_logging();
+
     md::EventBus bus(1024, 1024);
     static constexpr uint64_t NS_PER_10MS = 10'000'000ULL;
     md::BarBuilder bar_builder(bus, NS_PER_10MS);
@@ -48,6 +51,10 @@ int main() {
         1
     );
 
+    // flag any subscriber that cannot keep up with the replay
+    bus.set_slow_callback_threshold(1ms);
+    bus.start_watchdog();
+
     md::StrategyManager mgr(bus);
     mgr.add_strategy(&strat_mom1);
     mgr.add_strategy(&strat_mom2);
@@ -69,11 +76,13 @@ int main() {
     strat_mom2.finalize();
     mgr.finalize_all();  // already handled by above 2 lines
 
+    bus.print_sub_stats();
     mgr.stop();
     bus.unsubscribe(sub_bars);
 
     bus.stop();
     bus.print_stats();
+    md::stop_async_logging();
 
     fmt::print("\n=== BarMomentum Strategy 1 (acct_mom1) ===\n");
     acct_mom1.print_summary();
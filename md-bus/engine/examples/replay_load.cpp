@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <fmt/core.h>
+
+#include "../bus/bus.hpp"
+#include "../common/event.hpp"
+#include "../common/log.hpp"
+#include "../replay/replay.hpp"
+
+// Load test: finds the busiest second of a recording, then replays the
+// recording through the bus at 2x, 5x and 10x that rate (and once in bursts)
+// and reports how far publishing fell behind schedule and what the
+// subscriber received.
+int main(int argc, char** argv) {
+    using namespace std::chrono_literals;
+    const std::string path = argc > 1 ? argv[1] : "logs/md_events.log";
+    const std::size_t max_events = argc > 2 ? std::stoul(argv[2]) : 200'000;
+
+    md::ReplayFilter all;
+    uint64_t bucket = 0, in_bucket = 0, peak = 0;
+    md::scan_events(path, all, [&](md::Event& e) {
+        const uint64_t b = e.h.ts_ns / 1'000'000'000ull;
+        if(b != bucket) {
+            bucket = b;
+            in_bucket = 0;
+        }
+        peak = std::max(peak, ++in_bucket);
+        return true;
+    });
+    if(peak == 0) {
+        md::log_error("replay_load: no events in '{}'", path);
+        return 1;
+    }
+    fmt::print("[LOAD] recorded peak: {} events/s\n", peak);
+
+    auto run = [&](const char* label, const md::ReplayRateConfig& cfg) {
+        md::EventBus bus(1 << 16, 1 << 16);
+        std::atomic<uint64_t> received{0};
+        bus.subscribe(md::Topic::MD_TICK, [&](const md::Event& e) {
+            if(std::holds_alternative<md::Tick>(e.p)) received.fetch_add(1, std::memory_order_relaxed);
+        }, "load-counter");
+
+        md::EventReplay replay(path);
+        replay.set_max_events(max_events);
+        const auto t0 = std::chrono::steady_clock::now();
+        replay.replay_rate(bus, cfg);
+        const auto secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::this_thread::sleep_for(200ms);
+        bus.stop();
+
+        const auto& st = replay.pacing_stats();
+        fmt::print("[LOAD] {:<12} target={:>10.0f}/s achieved={:>10.0f}/s lag mean={} ns p99={} ns "
+                   "max={} ns received={}\n",
+                   label, cfg.events_per_sec, st.events / secs, st.mean_lag_ns, st.p99_lag_ns,
+                   st.max_lag_ns, received.load());
+    };
+
+    for(int mult : {2, 5, 10}) {
+        md::ReplayRateConfig cfg;
+        cfg.events_per_sec = static_cast<double>(peak) * mult;
+        cfg.jitter_ns = 1'000;
+        run(fmt::format("{}x peak", mult).c_str(), cfg);
+    }
+
+    md::ReplayRateConfig burst;
+    burst.events_per_sec = static_cast<double>(peak) * 5;
+    burst.burst_events = 1000;
+    run("5x bursts", burst);
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <fmt/core.h>
+#include "../common/event.hpp"
+#include "../common/log.hpp"
+
+#include "../strategy/accounting.hpp"
+#include "../strategy/backtest.hpp"
+#include "../strategy/bar_momentum.hpp"
+#include "../strategy/sweep.hpp"
+
+// Grid search over BarMomentumStrategy's window size and momentum threshold.
+// The log is read and aggregated into bars once; every grid point then runs
+// over the same in-memory events on its own thread.
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "logs/md_events.log";
+    const std::string symbol = argc > 2 ? argv[2] : "NIFTY";
+    const unsigned threads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 0;
+
+    md::BacktestConfig cfg;
+    cfg.filter.add_topic(md::Topic::MD_TICK);
+    cfg.filter.add_symbol(symbol);
+
+    md::EventDataset data;
+    if(!data.load(path, cfg)) {
+        md::log_error("sweep: no events for '{}' in '{}'", symbol, path);
+        return 1;
+    }
+
+    md::ParameterSweep sweep;
+    for(std::size_t window : {1, 2, 5, 10, 20}) {
+        for(double thr : {0.0, 0.05, 0.1, 0.25, 0.5}) {
+            sweep.add(fmt::format("window={} thr={}", window, thr),
+                      [=](md::Account& acct) {
+                          return std::make_unique<md::BarMomentumStrategy>(
+                              acct, symbol, window, thr, 1);
+                      });
+        }
+    }
+
+    const auto results = sweep.run(data, threads);
+    fmt::print("\n=== BarMomentum sweep: {} points, {} events ===\n", sweep.size(), data.size());
+    md::ParameterSweep::print_results(results);
+    md::ParameterSweep::dump_csv(results, "sweep_barmomentum.csv");
+    return 0;
+}
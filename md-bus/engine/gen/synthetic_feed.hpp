@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../bus/bus.hpp"
+#include "../common/event.hpp"
+#include "../common/event_binary.hpp"
+
+namespace md {
+
+/*
+ * SyntheticFeed
+ * -------------
+ * Reproducible multi-symbol tick generator for load and scaling tests.
+ *
+ *  - Symbol universe: SYM000000 .. SYM<n-1> (up to kMaxSymbols), picked
+ *    uniformly or with a Zipf skew (a few symbols carry most of the flow).
+ *  - Arrivals: Poisson, or bursty (two-state Markov modulated Poisson:
+ *    quiet periods interleaved with bursts at burst_multiplier x the rate).
+ *    Either way the long run average is rate_eps events/sec.
+ *  - Prices: per-symbol geometric random walk rounded to tick_size.
+ *
+ * Timestamps come from a virtual clock starting at start_ts_ns, so writing
+ * to a file runs as fast as the disk allows; publish_live() paces against
+ * the wall clock instead.
+ */
+
+enum class ArrivalProcess {
+    Poisson,
+    Bursty,
+};
+
+struct SyntheticConfig {
+    std::size_t num_symbols{10};
+    std::string symbol_prefix{"SYM"};
+    double zipf_s{0.0};             // 0 = uniform symbol choice
+
+    ArrivalProcess arrival{ArrivalProcess::Poisson};
+    double rate_eps{10'000.0};      // target events/sec (long run average)
+    uint64_t total_events{100'000};
+
+    // bursty only
+    double burst_fraction{0.1};     // share of wall time spent bursting
+    double burst_multiplier{20.0};  // burst rate relative to quiet rate
+    uint64_t mean_burst_ns{50'000'000ULL};
+
+    // random walk
+    double start_price{100.0};
+    double volatility{0.0005};      // stddev of relative step per tick
+    double tick_size{0.01};
+    uint32_t min_qty{1};
+    uint32_t max_qty{500};
+
+    uint64_t seed{42};
+    uint64_t start_ts_ns{1'000'000'000ULL};
+};
+
+class SyntheticFeed {
+private :
+    SyntheticConfig cfg_;
+    std::mt19937_64 rng_;
+
+    std::vector<std::string> symbols_;
+    std::vector<double> prices_;
+    std::vector<double> zipf_cdf_;  // empty when uniform
+
+    uint64_t clock_ns_{0};
+    uint64_t produced_{0};
+
+    // bursty state
+    bool in_burst_{false};
+    uint64_t state_end_ns_{0};
+    double quiet_rate_{0.0};
+
+    std::size_t pick_symbol();
+    double next_gap_ns();
+    uint64_t draw_state_ns();
+    void maybe_switch_state();
+public :
+    static constexpr std::size_t kMaxSymbols = 100'000;
+
+    explicit SyntheticFeed(const SyntheticConfig& cfg);
+
+    // Produces the next MD_TICK event (seq + synthetic ts filled in).
+    // Returns false once total_events have been produced.
+    bool next(Event& out);
+
+    uint64_t produced() const { return produced_; }
+    const std::vector<std::string>& symbols() const { return symbols_; }
+
+    // Writes all events in recorder format (EventRecorder) to path.
+    // Returns the number of events written.
+    uint64_t write_to_file(const std::string& path, RecordFormat format = RecordFormat::Text);
+
+    // Publishes into a live bus, sleeping so that event i goes out at
+    // wall_start + (ts_i - start_ts). Events keep their synthetic ts_ns
+    // (publish_preserve), as in a written file; a full bus blocks the
+    // feed rather than dropping events. Returns the number published.
+    uint64_t publish_live(EventBus& bus);
+};
+
+}
@@ -0,0 +1,344 @@
+#include "journal.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "../common/log.hpp"
+
+namespace md {
+
+namespace fs = std::filesystem;
+
+static constexpr const char* kSegmentExt = ".mdj";
+
+// The first byte of a record publishes it (see journal.hpp).
+static inline uint8_t load_type_acquire(const char* p) {
+    return __atomic_load_n(reinterpret_cast<const uint8_t*>(p), __ATOMIC_ACQUIRE);
+}
+
+static inline void store_type_release(char* p, char v) {
+    __atomic_store_n(reinterpret_cast<uint8_t*>(p), static_cast<uint8_t>(v), __ATOMIC_RELEASE);
+}
+
+std::string journal_segment_name(uint64_t start_index) {
+    return fmt::format("{:020}{}", start_index, kSegmentExt);
+}
+
+std::vector<std::string> list_journal_segments(const std::string& dir) {
+    std::vector<std::string> out;
+    std::error_code ec;
+    for(const auto& entry : fs::directory_iterator(dir, ec)) {
+        const auto& p = entry.path();
+        if(p.extension() == kSegmentExt && p.stem().string().size() == 20) {
+            out.push_back(p.string());
+        }
+    }
+    // fixed-width names: lexical order is journal order
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// --- JournalWriter ---
+
+JournalWriter::JournalWriter(const std::string& dir, const JournalConfig& cfg)
+    : dir_{dir}, cfg_{cfg} {
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    if(ec) {
+        log_error("JournalWriter: cannot create '{}': {}", dir_, ec.message());
+        return;
+    }
+    if(cfg_.segment_bytes < kBinaryFileHeaderSize + 64) {
+        log_error("JournalWriter: segment_bytes {} is too small", cfg_.segment_bytes);
+        return;
+    }
+    recover();
+    ok_ = true;
+    log_info("JournalWriter: journal '{}' next_index={} segment_bytes={}",
+             dir_, next_index_, cfg_.segment_bytes);
+}
+
+JournalWriter::~JournalWriter() {
+    close();
+}
+
+// Seals the newest existing segment after its last complete record and
+// continues numbering from there.
+void JournalWriter::recover() {
+    const auto segs = list_journal_segments(dir_);
+    if(segs.empty()) return;
+
+    const std::string& last = segs.back();
+    const uint64_t start = std::strtoull(fs::path(last).stem().string().c_str(), nullptr, 10);
+
+    int fd = ::open(last.c_str(), O_RDWR | O_CLOEXEC);
+    struct stat st{};
+    if(fd < 0 || ::fstat(fd, &st) != 0) {
+        log_error("JournalWriter: cannot reopen '{}': {}", last, std::strerror(errno));
+        if(fd >= 0) ::close(fd);
+        next_index_ = start;
+        return;
+    }
+
+    const auto size = static_cast<std::size_t>(st.st_size);
+    uint64_t count = 0;
+    std::size_t end = size;
+    if(size >= kBinaryFileHeaderSize) {
+        void* m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if(m != MAP_FAILED) {
+            const char* base = static_cast<const char*>(m);
+            BinaryEventReader reader;
+            Event e;
+            std::size_t pos = kBinaryFileHeaderSize;
+            while(pos < size && base[pos] != 0) {
+                std::size_t used = 0;
+                if(reader.decode(base + pos, base + size, e, used) != DecodeStatus::Event) break;
+                pos += used;
+                ++count;
+            }
+            end = pos;
+            ::munmap(m, size);
+        }
+    }
+
+    // keep one zero byte as the terminator and drop the unused tail
+    if(end < size && ::ftruncate(fd, static_cast<off_t>(end + 1)) != 0) {
+        log_warn("JournalWriter: could not trim '{}': {}", last, std::strerror(errno));
+    }
+    ::close(fd);
+
+    next_index_ = start + count;
+    log_info("JournalWriter: resuming after '{}' ({} events)", last, count);
+}
+
+bool JournalWriter::open_segment() {
+    const std::string name = journal_segment_name(next_index_);
+    const std::string path = (fs::path(dir_) / name).string();
+    const std::string tmp = path + ".tmp";
+
+    int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        log_error("JournalWriter: cannot create '{}': {}", tmp, std::strerror(errno));
+        return false;
+    }
+
+    const auto len = static_cast<off_t>(cfg_.segment_bytes);
+    int rc = cfg_.preallocate ? ::posix_fallocate(fd, 0, len) : EOPNOTSUPP;
+    if(rc != 0 && ::ftruncate(fd, len) != 0) {
+        log_error("JournalWriter: cannot size '{}': {}", tmp, std::strerror(errno));
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+
+    void* m = ::mmap(nullptr, cfg_.segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(m == MAP_FAILED) {
+        log_error("JournalWriter: mmap of '{}' failed: {}", tmp, std::strerror(errno));
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+
+    base_ = static_cast<char*>(m);
+    cap_ = cfg_.segment_bytes;
+    fd_ = fd;
+
+    scratch_.clear();
+    write_binary_file_header(scratch_, kBinaryFlagZeroTerminated);
+    std::memcpy(base_, scratch_.data(), scratch_.size());
+    pos_ = scratch_.size();
+
+    // readers only look at *.mdj, so they never see a segment without a header
+    if(::rename(tmp.c_str(), path.c_str()) != 0) {
+        log_error("JournalWriter: cannot publish '{}': {}", path, std::strerror(errno));
+    }
+    seg_path_ = path;
+    bin_ = BinaryEventWriter{}; // every segment decodes on its own
+    ++segments_opened_;
+    MD_LOG_DEBUG("JournalWriter: opened segment '{}'", seg_path_);
+    return true;
+}
+
+void JournalWriter::seal_segment() {
+    if(!base_) return;
+    ::munmap(base_, cap_);
+    // pos_ is the zero terminator; readers may still map the old size, but
+    // never read past it
+    if(::ftruncate(fd_, static_cast<off_t>(pos_ + 1)) != 0) {
+        log_warn("JournalWriter: could not trim '{}': {}", seg_path_, std::strerror(errno));
+    }
+    ::close(fd_);
+    base_ = nullptr;
+    fd_ = -1;
+    cap_ = 0;
+    pos_ = 0;
+}
+
+void JournalWriter::on_event(const Event& e) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if(!ok_) return;
+
+    if(!base_ && !open_segment()) {
+        ++dropped_;
+        return;
+    }
+
+    scratch_.clear();
+    bin_.encode(e, scratch_);
+
+    // +1 keeps room for the terminating zero byte
+    if(pos_ + scratch_.size() + 1 > cap_) {
+        if(kBinaryFileHeaderSize + scratch_.size() + 1 > cfg_.segment_bytes) {
+            ++dropped_;
+            log_error("JournalWriter: event seq={} ({} bytes) does not fit in a segment",
+                      e.h.seq, scratch_.size());
+            return;
+        }
+        seal_segment();
+        if(!open_segment()) {
+            ++dropped_;
+            return;
+        }
+        scratch_.clear();
+        bin_.encode(e, scratch_); // re-encode against the fresh writer state
+    }
+
+    char* dst = base_ + pos_;
+    std::memcpy(dst + 1, scratch_.data() + 1, scratch_.size() - 1);
+    store_type_release(dst, scratch_[0]);
+    pos_ += scratch_.size();
+    ++next_index_;
+}
+
+void JournalWriter::flush() {
+    std::lock_guard<std::mutex> lk(mu_);
+    if(base_ && ::msync(base_, pos_, MS_SYNC) != 0) {
+        log_error("JournalWriter: msync of '{}' failed: {}", seg_path_, std::strerror(errno));
+    }
+}
+
+void JournalWriter::close() {
+    std::lock_guard<std::mutex> lk(mu_);
+    if(!ok_) return;
+    seal_segment();
+    ok_ = false;
+    if(dropped_ > 0) {
+        log_warn("JournalWriter: dropped {} events", dropped_);
+    }
+    log_info("JournalWriter: closed '{}' (next_index={}, {} segments opened)",
+             dir_, next_index_, segments_opened_);
+}
+
+uint64_t JournalWriter::next_index() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return next_index_;
+}
+
+uint64_t JournalWriter::segments_opened() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return segments_opened_;
+}
+
+// --- JournalReader ---
+
+JournalReader::JournalReader(const std::string& dir)
+    : dir_{dir} {
+    segments_ = list_journal_segments(dir_);
+    if(!segments_.empty()) map_segment(0);
+}
+
+JournalReader::~JournalReader() {
+    unmap();
+}
+
+void JournalReader::unmap() {
+    if(base_) ::munmap(const_cast<char*>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+    pos_ = 0;
+}
+
+bool JournalReader::map_segment(std::size_t idx) {
+    unmap();
+    seg_idx_ = idx;
+    bin_ = BinaryEventReader{};
+
+    int fd = ::open(segments_[idx].c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if(fd < 0 || ::fstat(fd, &st) != 0) {
+        log_error("JournalReader: cannot open '{}': {}", segments_[idx], std::strerror(errno));
+        if(fd >= 0) ::close(fd);
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* m = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if(m == MAP_FAILED) {
+        log_error("JournalReader: mmap of '{}' failed", segments_[idx]);
+        return false;
+    }
+    base_ = static_cast<const char*>(m);
+    size_ = size;
+
+    uint16_t flags = 0;
+    if(!read_binary_file_header(std::string_view(base_, size_), flags)) {
+        log_error("JournalReader: '{}' is not a journal segment", segments_[idx]);
+        unmap();
+        return false;
+    }
+    bin_.set_checksums((flags & kBinaryFlagChecksummed) != 0);
+    ::madvise(const_cast<char*>(base_), size_, MADV_SEQUENTIAL);
+    pos_ = kBinaryFileHeaderSize;
+    return true;
+}
+
+bool JournalReader::at_end_of_data() const {
+    return pos_ >= size_ || load_type_acquire(base_ + pos_) == 0;
+}
+
+bool JournalReader::next(Event& out) {
+    if(corrupt_) return false;
+    for(;;) {
+        if(!base_) {
+            // nothing mapped yet (empty journal or a failed map): look again
+            segments_ = list_journal_segments(dir_);
+            if(seg_idx_ >= segments_.size() || !map_segment(seg_idx_)) return false;
+        }
+
+        if(!at_end_of_data()) {
+            std::size_t used = 0;
+            const DecodeStatus st = bin_.decode(base_ + pos_, base_ + size_, out, used);
+            if(st == DecodeStatus::Event) {
+                pos_ += used;
+                ++events_;
+                return true;
+            }
+            log_error("JournalReader: bad record at offset {} in '{}', stopping",
+                      pos_, segments_[seg_idx_]);
+            corrupt_ = true;
+            return false;
+        }
+
+        // Caught up with this segment. Move on only if the writer has started
+        // a newer one; it seals a segment before opening the next, so
+        // re-checking afterwards cannot miss a final record.
+        if(seg_idx_ + 1 >= segments_.size()) {
+            segments_ = list_journal_segments(dir_);
+            if(seg_idx_ + 1 >= segments_.size()) return false;
+        }
+        if(!at_end_of_data()) continue;
+        if(!map_segment(seg_idx_ + 1)) return false;
+    }
+}
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../common/event.hpp"
+#include "../common/event_binary.hpp"
+
+namespace md {
+
+/*
+ * Segmented, memory-mapped event journal
+ * --------------------------------------
+ * A journal is a directory of segment files:
+ *
+ *   <dir>/00000000000000000000.mdj
+ *   <dir>/00000000000001048213.mdj
+ *   ...
+ *
+ * Each segment is a self-contained binary log (event_binary.hpp) with the
+ * kBinaryFlagZeroTerminated header flag. It is pre-allocated to
+ * segment_bytes and mapped MAP_SHARED, so appending an event is a memcpy
+ * into the mapping: no syscall per event.
+ *
+ * Segments are named after the journal sequence of their first event. The
+ * journal counts events across restarts (the bus seq starts again at 1 in
+ * every process), so names stay unique and sort in write order.
+ *
+ * Each encoded event (with any SYMBOL record it needs) is copied in with
+ * its first byte stored last, with release ordering. A zero type byte
+ * therefore marks the end of the data, and a reader mapping the same
+ * segment read-only never sees a half-written record. That holds even for
+ * a live reader running while the writer appends.
+ *
+ * A writer that reopens an existing journal seals the last segment after
+ * its last complete record and continues in a new segment.
+ */
+
+struct JournalConfig {
+    std::size_t segment_bytes{64u << 20};
+    // posix_fallocate the segment up front; otherwise a sparse ftruncate.
+    // Pre-allocation keeps a full disk from turning into SIGBUS mid-write.
+    bool preallocate{true};
+};
+
+// "<20-digit start>.mdj"
+std::string journal_segment_name(uint64_t start_index);
+// Full paths of the segments in dir, in journal order.
+std::vector<std::string> list_journal_segments(const std::string& dir);
+
+class JournalWriter {
+private :
+    mutable std::mutex mu_;
+    std::string dir_;
+    JournalConfig cfg_;
+    bool ok_{false};
+
+    // current segment
+    int fd_{-1};
+    char* base_{nullptr};
+    std::size_t cap_{0};
+    std::size_t pos_{0};
+    std::string seg_path_;
+
+    uint64_t next_index_{0};   // journal sequence of the next event
+    uint64_t segments_opened_{0};
+    uint64_t dropped_{0};
+
+    BinaryEventWriter bin_;
+    std::string scratch_;
+
+    bool open_segment();
+    void seal_segment();
+    void recover();
+public :
+    explicit JournalWriter(const std::string& dir, const JournalConfig& cfg = {});
+    ~JournalWriter();
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    bool ok() const { return ok_; }
+
+    // Same shape as EventRecorder::on_event, so it can sit behind subscribe_all.
+    void on_event(const Event& e);
+
+    // msync()s everything written to the current segment.
+    void flush();
+    void close();
+
+    uint64_t next_index() const;
+    uint64_t segments_opened() const;
+};
+
+/*
+ * JournalReader
+ * -------------
+ * Maps the segments of a journal read-only and decodes them in order.
+ * next() returns false once it has caught up with the writer; calling it
+ * again later picks up anything appended since, including new segments.
+ */
+class JournalReader {
+private :
+    std::string dir_;
+    std::vector<std::string> segments_;
+    std::size_t seg_idx_{0};
+
+    const char* base_{nullptr};
+    std::size_t size_{0};
+    std::size_t pos_{0};
+    BinaryEventReader bin_;
+    uint64_t events_{0};
+    bool corrupt_{false};
+
+    bool map_segment(std::size_t idx);
+    void unmap();
+    bool at_end_of_data() const;
+public :
+    explicit JournalReader(const std::string& dir);
+    ~JournalReader();
+
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    bool ok() const { return !corrupt_; }
+    bool next(Event& out);
+    uint64_t events() const { return events_; }
+};
+
+}
@@ -0,0 +1,153 @@
+#include "log_convert.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "../common/event_io.hpp"
+#include "../common/log.hpp"
+#include "recorder.hpp"
+
+namespace md {
+
+namespace fs = std::filesystem;
+
+static bool same_double(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+bool same_event(const Event& a, const Event& b) {
+    if(a.h.seq != b.h.seq || a.h.ts_ns != b.h.ts_ns || a.h.topic != b.h.topic) return false;
+    if(a.p.index() != b.p.index()) return false;
+    if(const auto* x = std::get_if<Tick>(&a.p)) {
+        const auto& y = std::get<Tick>(b.p);
+        return x->symbol == y.symbol && same_double(x->pq, y.pq) && x->qty == y.qty;
+    }
+    if(const auto* x = std::get_if<Bar>(&a.p)) {
+        const auto& y = std::get<Bar>(b.p);
+        return x->symbol == y.symbol && same_double(x->open, y.open) &&
+               same_double(x->high, y.high) && same_double(x->low, y.low) &&
+               same_double(x->close, y.close) && x->volume == y.volume &&
+               x->start_ts_ns == y.start_ts_ns && x->end_ts_ns == y.end_ts_ns;
+    }
+    if(const auto* x = std::get_if<std::string>(&a.p)) {
+        return *x == std::get<std::string>(b.p);
+    }
+    return true;
+}
+
+// File size, or the total of a journal's segments.
+static uint64_t log_bytes(const std::string& path) {
+    std::error_code ec;
+    if(fs::is_directory(path, ec)) {
+        uint64_t total = 0;
+        for(const auto& seg : list_journal_segments(path)) total += fs::file_size(seg, ec);
+        return total;
+    }
+    const auto n = fs::file_size(path, ec);
+    return ec ? 0 : n;
+}
+
+bool convert_log(const std::string& in, const std::string& out, RecordFormat to,
+                 const ConvertConfig& cfg, ConvertStats* stats) {
+    EventBatchReader reader(in, cfg);
+    if(!reader.ok()) {
+        log_error("convert_log: cannot read '{}'", in);
+        return false;
+    }
+
+    ConvertStats st;
+    bool written = false;
+    {
+        EventRecorder rec(out, to);
+        std::vector<Event> batch;
+        while(reader.next_batch(batch)) {
+            rec.on_events(batch.data(), batch.size());
+            st.events += batch.size();
+        }
+        rec.close();
+        written = rec.ok();
+    }
+    st.parse_errors = reader.parse_errors();
+    st.bytes_in = log_bytes(in);
+    st.bytes_out = log_bytes(out);
+    if(stats) *stats = st;
+
+    if(!written) {
+        log_error("convert_log: writing '{}' failed", out);
+        return false;
+    }
+    if(st.parse_errors > 0) {
+        log_error("convert_log: {} unreadable records in '{}' were not converted",
+                  st.parse_errors, in);
+        return false;
+    }
+    log_info("convert_log: '{}' ({}) -> '{}' ({}): {} events, {} -> {} bytes",
+             in, to_string(reader.format()), out, to_string(to),
+             st.events, st.bytes_in, st.bytes_out);
+    return true;
+}
+
+bool verify_logs(const std::string& a, const std::string& b,
+                 const ConvertConfig& cfg, VerifyStats* stats) {
+    static constexpr uint64_t kReportedMismatches = 10;
+
+    EventBatchReader ra(a, cfg), rb(b, cfg);
+    if(!ra.ok() || !rb.ok()) {
+        log_error("verify_logs: cannot read '{}'", ra.ok() ? b : a);
+        return false;
+    }
+
+    VerifyStats st;
+    std::vector<Event> ba, bb;
+    std::size_t ia = 0, ib = 0;
+    for(;;) {
+        if(ia == ba.size()) {
+            ia = 0;
+            if(!ra.next_batch(ba)) ba.clear();
+        }
+        if(ib == bb.size()) {
+            ib = 0;
+            if(!rb.next_batch(bb)) bb.clear();
+        }
+        const bool have_a = ia < ba.size();
+        const bool have_b = ib < bb.size();
+        if(!have_a && !have_b) break;
+        if(have_a != have_b) {
+            // one side is longer: count the rest without comparing
+            if(have_a) { st.events_a += ba.size() - ia; ia = ba.size(); }
+            else { st.events_b += bb.size() - ib; ib = bb.size(); }
+            continue;
+        }
+
+        const std::size_t n = std::min(ba.size() - ia, bb.size() - ib);
+        for(std::size_t k = 0; k < n; ++k) {
+            const Event& x = ba[ia + k];
+            const Event& y = bb[ib + k];
+            if(same_event(x, y)) continue;
+            const uint64_t event_no = st.events_a + k + 1;
+            if(st.mismatches == 0) st.first_mismatch = event_no;
+            if(++st.mismatches <= kReportedMismatches) {
+                log_error("verify_logs: event {} differs:\n  {}: {}\n  {}: {}",
+                          event_no, a, serialize_event(x), b, serialize_event(y));
+            }
+        }
+        ia += n;
+        ib += n;
+        st.events_a += n;
+        st.events_b += n;
+    }
+    st.parse_errors = ra.parse_errors() + rb.parse_errors();
+    if(stats) *stats = st;
+
+    const bool same = st.mismatches == 0 && st.events_a == st.events_b && st.parse_errors == 0;
+    if(same) {
+        log_info("verify_logs: '{}' and '{}' hold the same {} events", a, b, st.events_a);
+    } else {
+        log_error("verify_logs: '{}' ({} events) vs '{}' ({} events): {} differ, {} unreadable records",
+                  a, st.events_a, b, st.events_b, st.mismatches, st.parse_errors);
+    }
+    return same;
+}
+
+}
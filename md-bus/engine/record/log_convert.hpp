@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "../common/event.hpp"
+#include "../common/event_binary.hpp"
+#include "../replay/batch_reader.hpp"
+
+namespace md {
+
+// The converter reads through EventBatchReader and takes its settings.
+using ConvertConfig = BatchReaderConfig;
+
+struct ConvertStats {
+    uint64_t events{0};
+    uint64_t parse_errors{0};
+    uint64_t bytes_in{0};
+    uint64_t bytes_out{0};
+};
+
+struct VerifyStats {
+    uint64_t events_a{0};
+    uint64_t events_b{0};
+    uint64_t mismatches{0};
+    uint64_t first_mismatch{0};  // event number (1-based), 0 if none
+    uint64_t parse_errors{0};
+};
+
+// Exact equality: header fields, payload alternative, strings, and the bit
+// patterns of every double.
+bool same_event(const Event& a, const Event& b);
+
+// Rewrites in as out in the given format, with a .idx sidecar. False if the
+// input could not be opened, out could not be written, or any input record
+// failed to parse (the rest is still converted).
+bool convert_log(const std::string& in, const std::string& out, RecordFormat to,
+                 const ConvertConfig& cfg = {}, ConvertStats* stats = nullptr);
+
+// True if a and b hold the same events in the same order (in any formats)
+// and neither has unreadable records. Logs the first few differences.
+bool verify_logs(const std::string& a, const std::string& b,
+                 const ConvertConfig& cfg = {}, VerifyStats* stats = nullptr);
+
+}
@@ -1,18 +1,67 @@
 #include "recorder.hpp"
 
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/byte_scan.hpp"
+
 namespace md {
 
-EventRecorder::EventRecorder(const std::string& path)
-    :path_{path} {
+EventRecorder::EventRecorder(const std::string& path, RecordFormat format, const RecorderConfig& cfg)
+    :path_{path}, format_{format}, cfg_{cfg} {
         std::filesystem::create_directories("logs");
-        out_.open(path_, std::ios::out | std::ios::trunc);
-        if(!out_){
-            log_error("EventRecorder : failed to open file '{}'",path_);
+        // append mode maps the file to scan it, hence O_RDWR
+        const int flags = cfg_.append ? O_RDWR | O_CREAT | O_CLOEXEC
+                                      : O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        fd_ = ::open(path_.c_str(), flags, 0644);
+        if(fd_ < 0){
+            log_error("EventRecorder : failed to open file '{}': {}", path_, std::strerror(errno));
             opened_ = false;
-        }else {
-            opened_ = true;
-            log_info("EventRecorder : recording to '{}'", path_);
+            failed_ = true;
+            return;
+        }
+
+        std::error_code ec;
+        std::filesystem::remove(index_path_for(path_), ec); // rebuilt below / belongs to the old contents
+
+        if(format_ == RecordFormat::Columnar && cfg_.column_block_events == 0) {
+            cfg_.column_block_events = 4096;
+        }
+        if(cfg_.index_block_events > 0) {
+            index_ = std::make_unique<EventIndexBuilder>(format_, cfg_.index_block_events);
+        }
+        if(cfg_.append && !recover_existing()) {
+            ::close(fd_);
+            fd_ = -1;
+            failed_ = true;
+            return;
+        }
+
+        opened_ = true;
+        active_.reserve(cfg_.flush_bytes + cfg_.flush_bytes / 4);
+        spare_.reserve(cfg_.flush_bytes + cfg_.flush_bytes / 4);
+        const uint16_t header_flags = cfg_.checksums ? kBinaryFlagChecksummed : 0;
+        bin_.set_checksums(cfg_.checksums);
+        if(logical_bytes_ == 0) {
+            if(format_ == RecordFormat::Binary) {
+                write_binary_file_header(active_, header_flags);
+            } else if(format_ == RecordFormat::Columnar) {
+                write_columnar_file_header(active_, header_flags);
+            }
+        } else if(format_ == RecordFormat::Binary) {
+            bin_.sync(active_); // the appended events' deltas start from zero
         }
+        logical_bytes_ += active_.size();
+        if(index_) index_->set_data_bytes(logical_bytes_);
+        last_fsync_ = std::chrono::steady_clock::now();
+        writer_ = std::thread([this] { writer_loop(); });
+        log_info("EventRecorder : recording to '{}' ({}{})", path_,
+                 to_string(format_), cfg_.checksums ? ", checksummed" : "");
     }
 
 EventRecorder::~EventRecorder() {
@@ -20,28 +69,329 @@ EventRecorder::~EventRecorder() {
 }
 
 void EventRecorder::on_event(const Event& e){
-    if(!opened_)return;
-    std::lock_guard<std::mutex> lk(mu_);
-    if(!out_)return;
-    const std::string line = serialize_event(e);
-    out_ << line << '\n';
+    on_events(&e, 1);
 }
 
-void EventRecorder::flush() {
-    std::lock_guard<std::mutex> lk(mu_);
-    if(out_) {
-        out_.flush(); // std::flush();
+void EventRecorder::on_events(const Event* events, std::size_t n){
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if(!opened_ || stopping_) return;
+        for(std::size_t i = 0; i < n; ++i) append_locked(events[i]);
+        pending_events_ += n;
+        const bool group_full = cfg_.flush_events > 0 && pending_events_ >= cfg_.flush_events;
+        if(group_full && format_ == RecordFormat::Columnar) cut_column_block();
+        wake = group_full || active_.size() >= cfg_.flush_bytes;
     }
+    if(wake) cv_.notify_one();
+}
+
+// Encodes e into the active buffer. Caller holds mu_.
+void EventRecorder::append_locked(const Event& e) {
+    if(format_ == RecordFormat::Columnar) {
+        // index blocks are codec blocks; data_bytes moves when one is cut
+        if(index_) {
+            if(col_.pending() == 0) index_->begin_block(logical_bytes_);
+            index_->add(e);
+        }
+        col_.add(e);
+        if(col_.pending() >= cfg_.column_block_events) cut_column_block();
+        return;
+    }
+    const std::size_t before = active_.size();
+    if(index_) {
+        if(index_->block_full()) {
+            index_->begin_block(logical_bytes_);
+            // binary blocks must decode on their own
+            if(format_ == RecordFormat::Binary) bin_.sync(active_);
+        }
+        index_->add(e);
+    }
+    if(format_ == RecordFormat::Binary) {
+        bin_.encode(e, active_);
+    } else {
+        append_event(active_, e);
+        active_.push_back('\n');
+    }
+    logical_bytes_ += active_.size() - before;
+    if(index_) index_->set_data_bytes(logical_bytes_);
+}
+
+// Encodes the pending columnar events into the active buffer. Caller holds mu_.
+void EventRecorder::cut_column_block() {
+    if(col_.pending() == 0) return;
+    const std::size_t before = active_.size();
+    col_.encode_block(active_);
+    if(cfg_.checksums) put_u32(active_, crc32c(active_.data() + before, active_.size() - before));
+    pending_events_ = 0;
+    logical_bytes_ += active_.size() - before;
+    if(index_) index_->set_data_bytes(logical_bytes_);
+}
+
+void EventRecorder::write_out(const std::string& buf) {
+    const char* p = buf.data();
+    std::size_t left = buf.size();
+    while(left > 0) {
+        const ssize_t n = ::write(fd_, p, left);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            ++write_errors_;
+            failed_ = true;
+            log_error("EventRecorder : write to '{}' failed: {} ({} bytes lost)",
+                      path_, std::strerror(errno), left);
+            return;
+        }
+        p += n;
+        left -= static_cast<std::size_t>(n);
+        bytes_written_ += static_cast<uint64_t>(n);
+    }
+}
+
+void EventRecorder::maybe_fsync(bool force) {
+    if(cfg_.fsync == FsyncPolicy::Never || bytes_synced_ == bytes_written_) return;
+    const auto now = std::chrono::steady_clock::now();
+    if(!force && cfg_.fsync == FsyncPolicy::Periodic && now - last_fsync_ < cfg_.fsync_interval) {
+        return;
+    }
+    if(::fdatasync(fd_) != 0) {
+        log_error("EventRecorder : fdatasync on '{}' failed: {}", path_, std::strerror(errno));
+    }
+    last_fsync_ = now;
+    bytes_synced_ = bytes_written_;
+}
+
+void EventRecorder::writer_loop() {
+    std::unique_lock<std::mutex> lk(mu_);
+    for(;;) {
+        cv_.wait_for(lk, cfg_.flush_interval, [this] {
+            return stopping_ || flush_requested_ != flush_done_ || active_.size() >= cfg_.flush_bytes ||
+                   (cfg_.flush_events > 0 && pending_events_ >= cfg_.flush_events);
+        });
+        const bool stop = stopping_;
+        const uint64_t target = flush_requested_;
+
+        spare_.swap(active_);
+        // columnar events still waiting in col_ count until their block is cut
+        if(format_ != RecordFormat::Columnar) pending_events_ = 0;
+        lk.unlock();
+
+        if(!spare_.empty()) {
+            write_out(spare_);
+            spare_.clear(); // keeps capacity for the next swap
+        }
+        maybe_fsync(stop || target != flush_done_);
+
+        lk.lock();
+        if(target != flush_done_) {
+            flush_done_ = target;
+            done_cv_.notify_all();
+        }
+        if(stop && active_.empty()) break;
+    }
+}
+
+// --- append mode recovery ---
+
+// Scans the existing file, cuts it back after its last intact record and
+// primes the encoders and index to continue it. False if it cannot be
+// continued (different format, journal segment, I/O error).
+bool EventRecorder::recover_existing() {
+    struct stat st{};
+    if(::fstat(fd_, &st) != 0) {
+        log_error("EventRecorder : cannot stat '{}': {}", path_, std::strerror(errno));
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    if(size == 0) return true;
+
+    void* m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+    if(m == MAP_FAILED) {
+        log_error("EventRecorder : cannot map '{}': {}", path_, std::strerror(errno));
+        return false;
+    }
+    const char* base = static_cast<const char*>(m);
+    ::madvise(m, size, MADV_SEQUENTIAL);
+
+    const std::string_view head(base, std::min(size, kBinaryFileHeaderSize));
+    const RecordFormat found = looks_like_columnar_log(head) ? RecordFormat::Columnar
+                             : looks_like_binary_log(head)   ? RecordFormat::Binary
+                                                             : RecordFormat::Text;
+    uint64_t end = 0;
+    uint64_t events = 0;
+    bool ok = true;
+    if(found != format_) {
+        log_error("EventRecorder : cannot append {} records to '{}', which holds a {} log",
+                  to_string(format_), path_, to_string(found));
+        ok = false;
+    } else {
+        switch(format_) {
+            case RecordFormat::Text : end = recover_text(base, size, events); break;
+            case RecordFormat::Binary : end = recover_binary(base, size, events); break;
+            case RecordFormat::Columnar : end = recover_columnar(base, size, events); break;
+        }
+        ok = end != UINT64_MAX;
+    }
+    ::munmap(m, size);
+    if(!ok) return false;
+
+    if(end < size) {
+        if(::ftruncate(fd_, static_cast<off_t>(end)) != 0) {
+            log_error("EventRecorder : cannot truncate '{}': {}", path_, std::strerror(errno));
+            return false;
+        }
+        log_warn("EventRecorder : dropped {} bytes of torn or damaged data at the end of '{}'",
+                 size - end, path_);
+    }
+    if(::lseek(fd_, static_cast<off_t>(end), SEEK_SET) < 0) {
+        log_error("EventRecorder : cannot seek in '{}': {}", path_, std::strerror(errno));
+        return false;
+    }
+    logical_bytes_ = end;
+    bytes_written_ = end;
+    bytes_synced_ = end;
+    log_info("EventRecorder : appending to '{}' after {} events ({} bytes)", path_, events, end);
+    return true;
+}
+
+// Keeps every complete line; drops an unterminated final fragment. Lines
+// that do not parse are left in place (readers skip them).
+uint64_t EventRecorder::recover_text(const char* base, std::size_t size, uint64_t& events) {
+    const char* end = base + size;
+    const char* p = base;
+    Event e;
+    while(p < end) {
+        const char* nl = find_byte(p, end, '\n');
+        if(nl == end) break;
+        const std::string_view line(p, static_cast<std::size_t>(nl - p));
+        if(!line.empty() && parse_event(line, e)) {
+            if(index_) {
+                if(index_->block_full()) index_->begin_block(static_cast<uint64_t>(p - base));
+                index_->add(e);
+            }
+            ++events;
+        } else if(!line.empty()) {
+            log_warn("EventRecorder : '{}' has an unparseable line at offset {}", path_, p - base);
+        }
+        p = nl + 1;
+    }
+    return static_cast<uint64_t>(p - base);
+}
+
+uint64_t EventRecorder::recover_binary(const char* base, std::size_t size, uint64_t& events) {
+    uint16_t flags = 0;
+    if(size < kBinaryFileHeaderSize) return 0; // torn header: start over
+    if(!read_binary_file_header(std::string_view(base, size), flags) ||
+       (flags & kBinaryFlagZeroTerminated)) {
+        log_error("EventRecorder : '{}' has an unsupported binary header", path_);
+        return UINT64_MAX;
+    }
+    cfg_.checksums = (flags & kBinaryFlagChecksummed) != 0;
+
+    BinaryEventReader reader;
+    reader.set_checksums(cfg_.checksums);
+    Event e;
+    std::size_t pos = kBinaryFileHeaderSize;
+    std::size_t known_symbols = 0; // defined ahead of intact events
+    while(pos < size) {
+        // index blocks begin where the previous session started them (SYNC)
+        const bool new_block = index_ && (index_->index().blocks().empty() ||
+                                          static_cast<RecordType>(base[pos]) == RecordType::Sync);
+        std::size_t used = 0;
+        const DecodeStatus st = reader.decode(base + pos, base + size, e, used);
+        // Cut at the last intact event: SYMBOL / SYNC records after it went
+        // out with an event that did not make it, and the rebuilt index
+        // only knows the symbols of events that decoded.
+        if(st != DecodeStatus::Event) break;
+        if(new_block) index_->begin_block(pos);
+        if(index_) index_->add(e);
+        pos += used;
+        known_symbols = reader.symbols().size();
+        ++events;
+    }
+    std::vector<std::string> syms = reader.symbols();
+    syms.resize(known_symbols);
+    bin_.set_symbols(syms);
+    return pos;
+}
+
+uint64_t EventRecorder::recover_columnar(const char* base, std::size_t size, uint64_t& events) {
+    uint16_t flags = 0;
+    if(size < kBinaryFileHeaderSize) return 0;
+    if(!read_columnar_file_header(std::string_view(base, size), flags)) {
+        log_error("EventRecorder : '{}' has an unsupported columnar header", path_);
+        return UINT64_MAX;
+    }
+    cfg_.checksums = (flags & kBinaryFlagChecksummed) != 0;
+    const std::size_t crc_bytes = cfg_.checksums ? kRecordChecksumSize : 0;
+
+    ColumnBlockDecoder dec;
+    std::vector<Event> batch;
+    std::vector<char> body;
+    std::size_t known_symbols = 0; // defined by intact blocks
+    std::size_t pos = kBinaryFileHeaderSize;
+    while(size - pos >= kColumnBlockHeaderSize) {
+        uint32_t body_bytes = 0, n_events = 0;
+        read_column_block_header(base + pos, body_bytes, n_events);
+        const std::size_t total = kColumnBlockHeaderSize + body_bytes + crc_bytes;
+        if(size - pos < total) break;
+        const char* b = base + pos + kColumnBlockHeaderSize;
+        if(crc_bytes && get_u32(b + body_bytes) != crc32c(base + pos, kColumnBlockHeaderSize + body_bytes)) {
+            break;
+        }
+        body.assign(b, b + body_bytes);
+        body.resize(body_bytes + kColumnPad, '\0');
+        if(!dec.decode_block(body.data(), body_bytes, n_events, batch)) break;
+        if(index_) {
+            index_->begin_block(pos);
+            for(const auto& e : batch) index_->add(e);
+        }
+        known_symbols = dec.symbols().size();
+        events += n_events;
+        pos += total;
+    }
+    std::vector<std::string> syms = dec.symbols();
+    syms.resize(known_symbols);
+    col_.set_symbols(syms);
+    return pos;
+}
+
+void EventRecorder::save_index(const EventIndex& idx) const {
+    if(!idx.save_for(path_)) {
+        log_warn("EventRecorder : could not write index '{}'", index_path_for(path_));
+    }
+}
+
+void EventRecorder::flush() {
+    std::unique_lock<std::mutex> lk(mu_);
+    if(!opened_ || stopping_) return;
+    if(format_ == RecordFormat::Columnar) cut_column_block();
+    // snapshot first: the data written below covers everything it indexes
+    std::unique_ptr<EventIndex> snap;
+    if(index_) snap = std::make_unique<EventIndex>(index_->index());
+    const uint64_t target = ++flush_requested_;
+    cv_.notify_one();
+    done_cv_.wait(lk, [&] { return flush_done_ >= target || stopping_; });
+    lk.unlock();
+    if(snap) save_index(*snap);
 }
 
 void EventRecorder::close() {
-    std::lock_guard<std::mutex> lk(mu_);
-    if(out_) {
-        out_.flush();
-        out_.close();
-        log_info("EventRecorder : closed '{}'", path_);
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if(!opened_) return;
+        if(format_ == RecordFormat::Columnar) cut_column_block();
+        opened_ = false;
+        stopping_ = true;
     }
-    opened_ = false;
+    cv_.notify_one();
+    done_cv_.notify_all();
+    if(writer_.joinable()) writer_.join();
+
+    ::close(fd_);
+    fd_ = -1;
+    if(index_ && write_errors_ == 0) save_index(index_->index());
+    log_info("EventRecorder : closed '{}' ({} bytes{})", path_, bytes_written_,
+             write_errors_ ? ", write errors" : "");
 }
 
-}
\ No newline at end of file
+}
@@ -1,34 +1,148 @@
-#pragma once 
+#pragma once
 
-#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 
 #include "../common/event.hpp"
+#include "../common/column_codec.hpp"
+#include "../common/event_binary.hpp"
+#include "../common/event_index.hpp"
 #include "../common/event_io.hpp"
 #include "../common/log.hpp"
 
 namespace md{
 
+// When the recorder's data is forced to stable storage.
+enum class FsyncPolicy {
+    Never,       // leave it to the page cache
+    EveryFlush,  // fsync after every buffer write
+    Periodic,    // fsync at most once per fsync_interval
+};
+
+struct RecorderConfig {
+    // The writer thread swaps buffers once the active one holds flush_bytes,
+    // or flush_interval after the last swap, whichever comes first.
+    std::size_t flush_bytes{1u << 20};
+    std::chrono::milliseconds flush_interval{50};
+
+    FsyncPolicy fsync{FsyncPolicy::Never};
+    std::chrono::milliseconds fsync_interval{1000};
+
+    // Events per block of the <path>.idx sidecar (common/event_index.hpp),
+    // rewritten on flush() and close(). 0 disables the index.
+    uint64_t index_block_events{4096};
+
+    // Columnar format: events per codec block. Index blocks follow codec
+    // blocks in that format. flush() and close() cut a partial block.
+    std::size_t column_block_events{4096};
+
+    // Continue an existing log instead of truncating it. The file is
+    // scanned on open and cut back after its last intact record (a torn
+    // tail from a crash); encoder state and the index are rebuilt from the
+    // scan. The file must hold the same format.
+    bool append{false};
+
+    // Binary / columnar: a CRC32C after every record / block
+    // (kBinaryFlagChecksummed). When appending, the existing header decides.
+    bool checksums{false};
+
+    // Group commit: also hand the buffer to the writer once this many
+    // events are pending (0 = only flush_bytes / flush_interval). With
+    // FsyncPolicy::EveryFlush each hand-off is one write + fdatasync for the
+    // whole group, so at most flush_interval or flush_events worth of events
+    // is at risk and there is no syscall per event. Columnar logs cut a
+    // (smaller) codec block at each group.
+    std::size_t flush_events{0};
+};
+
+/*
+ * EventRecorder
+ * -------------
+ * on_event() only encodes the event into the active in-memory buffer; a
+ * dedicated writer thread swaps it with the spare buffer and hands the full
+ * one to write(2). The subscriber thread never waits for disk: if the writer
+ * is still busy, the active buffer simply keeps growing.
+ *
+ * Unless disabled, a sparse time / symbol index is kept alongside the log
+ * so replays of a window or a single symbol can skip most of the file.
+ *
+ * For crash safety: append mode (restart without losing the previous
+ * session, torn tail repaired on open), per-record checksums, and group
+ * commit via flush_events / flush_interval with FsyncPolicy::EveryFlush.
+ */
 class EventRecorder {
 private:
     mutable std::mutex mu_;
-    std::ofstream out_;
+    std::condition_variable cv_;       // wakes the writer
+    std::condition_variable done_cv_;  // wakes flush() callers
+    int fd_{-1};
     bool opened_{false};
+    bool stopping_{false};
     std::string path_;
+    RecordFormat format_{RecordFormat::Text};
+    RecorderConfig cfg_;
+
+    BinaryEventWriter bin_;   // binary format state (deltas, symbol table)
+    ColumnBlockEncoder col_;  // columnar format state (pending block)
+    std::unique_ptr<EventIndexBuilder> index_;
+    uint64_t logical_bytes_{0};  // file size once every buffered byte is written
+
+    // guarded by mu_
+    std::string active_;
+    std::size_t pending_events_{0};  // in active_ (or col_) since the last swap
+    uint64_t flush_requested_{0};
+    uint64_t flush_done_{0};
+
+    // owned by the writer thread
+    std::string spare_;
+    std::chrono::steady_clock::time_point last_fsync_{};
+    uint64_t bytes_written_{0};
+    uint64_t bytes_synced_{0};
+    uint64_t write_errors_{0};
+    std::atomic<bool> failed_{false};  // open or write failure
+
+    std::thread writer_;
+
+    void writer_loop();
+    void write_out(const std::string& buf);
+    void maybe_fsync(bool force);
+    void save_index(const EventIndex& idx) const;
+    void cut_column_block();
+    void append_locked(const Event& e);
+    bool recover_existing();
+    uint64_t recover_text(const char* base, std::size_t size, uint64_t& events);
+    uint64_t recover_binary(const char* base, std::size_t size, uint64_t& events);
+    uint64_t recover_columnar(const char* base, std::size_t size, uint64_t& events);
 public:
-    explicit EventRecorder(const std::string& path);
+    explicit EventRecorder(const std::string& path,
+                           RecordFormat format = RecordFormat::Text,
+                           const RecorderConfig& cfg = {});
     ~EventRecorder();
 
     EventRecorder(const EventRecorder&) = delete;
     EventRecorder& operator=(const EventRecorder&) = delete;
-    
+
     void on_event(const Event& e);
+    // Same as on_event for each, taking the lock once (bulk conversion).
+    void on_events(const Event* events, std::size_t n);
 
+    // Blocks until everything recorded so far has been handed to the OS
+    // (and fsynced, unless the policy is Never).
     void flush();
     void close();
 
+    RecordFormat format() const { return format_; }
+    // False once opening or any write has failed; final after close().
+    bool ok() const { return !failed_; }
+
 };
 
 
-}
\ No newline at end of file
+}
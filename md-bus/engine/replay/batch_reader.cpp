@@ -0,0 +1,196 @@
+#include "batch_reader.hpp"
+
+#include <algorithm>
+
+#include "../common/byte_scan.hpp"
+#include "../common/event_io.hpp"
+#include "../common/log.hpp"
+
+namespace md {
+
+static constexpr std::size_t kSequentialBatch = 8192;
+
+EventBatchReader::EventBatchReader(const std::string& path, const BatchReaderConfig& cfg,
+                                   Predicate keep, const EventPrefilter& pre)
+    : path_{path}, cfg_{cfg}, keep_{std::move(keep)}, pre_{pre}, prefilter_{pre.active()} {
+    seq_ = std::make_unique<EventFileReader>(path_);
+    if(!seq_->ok()) return;
+    seq_->set_prefilter(pre_);
+    format_ = seq_->format();
+    ok_ = true;
+    if(cfg_.threads == 0) cfg_.threads = std::max(1u, std::thread::hardware_concurrency());
+    if(format_ != RecordFormat::Text || seq_->is_journal()) {
+        reader_ = std::thread([this] { decode_loop(); });
+        return;
+    }
+
+    seq_.reset();
+    in_.open(path_, std::ios::in | std::ios::binary);
+    if(!in_) {
+        log_error("EventBatchReader: failed to open '{}'", path_);
+        ok_ = false;
+        return;
+    }
+    if(cfg_.chunk_bytes == 0) cfg_.chunk_bytes = BatchReaderConfig{}.chunk_bytes;
+    reader_ = std::thread([this] { reader_loop(); });
+    for(unsigned i = 0; i < cfg_.threads; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+EventBatchReader::~EventBatchReader() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if(reader_.joinable()) reader_.join();
+    for(auto& w : workers_) w.join();
+}
+
+// Cuts the file into chunks ending at a newline. A line longer than a chunk
+// is carried over until it is complete.
+void EventBatchReader::reader_loop() {
+    const uint64_t window = 2ull * cfg_.threads;
+    std::string carry;
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait(lk, [&] { return stopping_ || produced_ - consumed_ < window; });
+            if(stopping_) break;
+        }
+        std::string chunk = std::move(carry);
+        carry.clear();
+        const std::size_t keep = chunk.size();
+        chunk.resize(keep + cfg_.chunk_bytes);
+        in_.read(&chunk[keep], static_cast<std::streamsize>(cfg_.chunk_bytes));
+        const auto got = static_cast<std::size_t>(in_.gcount());
+        chunk.resize(keep + got);
+        const bool eof = !in_;
+
+        if(!eof) {
+            const std::size_t nl = chunk.rfind('\n');
+            if(nl == std::string::npos) {
+                carry = std::move(chunk);
+                continue;
+            }
+            carry.assign(chunk, nl + 1, std::string::npos);
+            chunk.resize(nl + 1);
+        }
+        if(!chunk.empty()) {
+            std::lock_guard<std::mutex> lk(mu_);
+            pending_.emplace_back(produced_++, std::move(chunk));
+        }
+        cv_.notify_all();
+        if(eof) break;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        reader_done_ = true;
+    }
+    cv_.notify_all();
+}
+
+// Sequential formats: decode batches here and queue them as finished chunks.
+void EventBatchReader::decode_loop() {
+    const uint64_t window = 2ull * cfg_.threads;
+    uint64_t records = 0, errors = 0;
+    Event e;
+    for(bool more = true; more;) {
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait(lk, [&] { return stopping_ || produced_ - consumed_ < window; });
+            if(stopping_) break;
+        }
+        Chunk c;
+        c.events.reserve(kSequentialBatch);
+        for(std::size_t n = 0; n < kSequentialBatch; ++n) {
+            if(!seq_->next(e)) {
+                more = false;
+                break;
+            }
+            if(!keep_ || keep_(e)) c.events.push_back(std::move(e));
+        }
+        c.lines = seq_->records() - records;
+        c.errors = seq_->parse_errors() - errors;
+        records = seq_->records();
+        errors = seq_->parse_errors();
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            done_.emplace(produced_++, std::move(c));
+        }
+        cv_.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        reader_done_ = true;
+    }
+    cv_.notify_all();
+}
+
+void EventBatchReader::worker_loop() {
+    for(;;) {
+        std::pair<uint64_t, std::string> job;
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait(lk, [&] { return stopping_ || !pending_.empty() || reader_done_; });
+            if(stopping_ || pending_.empty()) return;
+            job = std::move(pending_.front());
+            pending_.pop_front();
+        }
+        Chunk c;
+        parse_chunk(job.second, c);
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            done_.emplace(job.first, std::move(c));
+        }
+        cv_.notify_all();
+    }
+}
+
+void EventBatchReader::parse_chunk(const std::string& text, Chunk& out) const {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    out.events.reserve(text.size() / 48);
+    while(p < end) {
+        const char* nl = find_byte(p, end, '\n');
+        const std::string_view line(p, static_cast<std::size_t>(nl - p));
+        p = nl + (nl != end);
+        ++out.lines;
+        if(line.empty() || (prefilter_ && !pre_.admits_line(line))) continue;
+        out.events.emplace_back();
+        if(!parse_event(line, out.events.back())) {
+            out.events.pop_back();
+            ++out.errors;
+            log_warn("EventBatchReader: failed to parse line in '{}': {}", path_, line);
+        } else if(keep_ && !keep_(out.events.back())) {
+            out.events.pop_back();
+        }
+    }
+}
+
+bool EventBatchReader::next_batch(std::vector<Event>& out) {
+    if(!ok_) return false;
+    for(;;) {
+        Chunk c;
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait(lk, [&] {
+                return done_.count(consumed_) > 0 || (reader_done_ && consumed_ == produced_);
+            });
+            auto it = done_.find(consumed_);
+            if(it == done_.end()) return false;
+            c = std::move(it->second);
+            done_.erase(it);
+            ++consumed_;
+        }
+        cv_.notify_all(); // the reader may be waiting for window space
+        records_ += c.lines;
+        parse_errors_ += c.errors;
+        if(c.events.empty()) continue;
+        out.swap(c.events);
+        return true;
+    }
+}
+
+}
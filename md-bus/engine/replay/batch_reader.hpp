@@ -0,0 +1,107 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/event.hpp"
+#include "../common/event_binary.hpp"
+#include "../common/event_filter.hpp"
+#include "event_reader.hpp"
+
+namespace md {
+
+struct BatchReaderConfig {
+    // Parser threads for text input; 0 = hardware concurrency.
+    unsigned threads{0};
+    // Text is handed to the parsers in chunks of about this size, cut at
+    // line boundaries.
+    std::size_t chunk_bytes{4u << 20};
+};
+
+/*
+ * EventBatchReader
+ * ----------------
+ * Reads a log (any format EventFileReader accepts) as batches of events in
+ * file order. Text logs are read by a reader thread, cut into chunks at
+ * line boundaries and parsed by a pool of worker threads; batches come
+ * back in chunk order. Binary / columnar logs are decoded sequentially on
+ * the reader thread, since their records depend on the previous ones, so
+ * decoding still overlaps with whatever the consumer does.
+ *
+ * An optional prefilter drops records before they are decoded (text lines
+ * on the worker threads), and an optional keep predicate runs where the
+ * events are decoded; events either rejects never reach next_batch().
+ *
+ * At most 2 * threads chunks are in flight, so memory stays bounded
+ * however far the consumer falls behind.
+ */
+class EventBatchReader {
+public :
+    using Predicate = std::function<bool(const Event&)>;
+private :
+    struct Chunk {
+        std::vector<Event> events;
+        uint64_t lines{0};
+        uint64_t errors{0};
+    };
+
+    std::string path_;
+    BatchReaderConfig cfg_;
+    Predicate keep_;
+    EventPrefilter pre_;
+    bool prefilter_{false};
+    bool ok_{false};
+    RecordFormat format_{RecordFormat::Text};
+    uint64_t parse_errors_{0};
+    uint64_t records_{0};
+
+    // binary / columnar / journal, decoded by the reader thread
+    std::unique_ptr<EventFileReader> seq_;
+
+    // text pipeline
+    std::ifstream in_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::pair<uint64_t, std::string>> pending_;  // chunks to parse
+    std::map<uint64_t, Chunk> done_;                          // parsed, by chunk no
+    uint64_t produced_{0};
+    uint64_t consumed_{0};
+    bool reader_done_{false};
+    bool stopping_{false};
+    std::thread reader_;
+    std::vector<std::thread> workers_;
+
+    void reader_loop();
+    void decode_loop();
+    void worker_loop();
+    void parse_chunk(const std::string& text, Chunk& out) const;
+public :
+    explicit EventBatchReader(const std::string& path, const BatchReaderConfig& cfg = {},
+                              Predicate keep = {}, const EventPrefilter& pre = {});
+    ~EventBatchReader();
+
+    EventBatchReader(const EventBatchReader&) = delete;
+    EventBatchReader& operator=(const EventBatchReader&) = delete;
+
+    bool ok() const { return ok_; }
+    RecordFormat format() const { return format_; }
+
+    // Replaces out with the next batch; false once the log is exhausted.
+    bool next_batch(std::vector<Event>& out);
+
+    // Records (text lines) handed out so far and how many of them failed to
+    // parse. Records dropped by the keep predicate are counted.
+    uint64_t records() const { return records_; }
+    uint64_t parse_errors() const { return parse_errors_; }
+};
+
+}
@@ -0,0 +1,430 @@
+#include "dataset_cache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/crc32c.hpp"
+#include "../common/log.hpp"
+#include "event_reader.hpp"
+
+namespace md {
+
+namespace {
+
+struct DatasetCounts {
+    uint64_t rows{0};
+    uint64_t bars{0};
+    uint64_t logs{0};
+    uint64_t log_bytes{0};
+    uint32_t symbols{0};
+    uint32_t symbol_bytes{0};
+};
+
+// Byte offsets of every array in a cache file with the given counts.
+struct DatasetLayout {
+    std::size_t seq, ts, price, qty, symbol, aux, topic, kind;
+    std::size_t bar_open, bar_high, bar_low, bar_close, bar_volume, bar_start, bar_end;
+    std::size_t log_off, log_text, sym_off, sym_text;
+    std::size_t total;
+
+    explicit DatasetLayout(const DatasetCounts& c) {
+        std::size_t at = kDatasetHeaderSize;
+        auto take = [&](std::size_t bytes) {
+            const std::size_t off = at;
+            at = (at + bytes + 7) & ~std::size_t{7};
+            return off;
+        };
+        seq = take(c.rows * 8);
+        ts = take(c.rows * 8);
+        price = take(c.rows * 8);
+        qty = take(c.rows * 4);
+        symbol = take(c.rows * 4);
+        aux = take(c.rows * 4);
+        topic = take(c.rows);
+        kind = take(c.rows);
+        bar_open = take(c.bars * 8);
+        bar_high = take(c.bars * 8);
+        bar_low = take(c.bars * 8);
+        bar_close = take(c.bars * 8);
+        bar_volume = take(c.bars * 4);
+        bar_start = take(c.bars * 8);
+        bar_end = take(c.bars * 8);
+        log_off = take((c.logs + 1) * 8);
+        log_text = take(c.log_bytes);
+        sym_off = take((std::size_t{c.symbols} + 1) * 4);
+        sym_text = take(c.symbol_bytes);
+        total = at;
+    }
+};
+
+template <typename T>
+void put_pod(std::string& out, std::size_t at, const T& v) {
+    std::memcpy(&out[at], &v, sizeof(T));
+}
+
+template <typename T>
+void put_array(std::string& out, std::size_t at, const std::vector<T>& v) {
+    if(!v.empty()) std::memcpy(&out[at], v.data(), v.size() * sizeof(T));
+}
+
+template <typename T>
+T get_pod(const char* p, std::size_t at) {
+    T v;
+    std::memcpy(&v, p + at, sizeof(T));
+    return v;
+}
+
+} // namespace
+
+bool dataset_source_key(const std::string& source, uint64_t& key, uint64_t& size) {
+    const int fd = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return false;
+    struct stat st{};
+    if(::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    uint32_t crc = 0;
+    if(size > 0) {
+        void* m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if(m == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        ::madvise(m, size, MADV_SEQUENTIAL);
+        crc = crc32c(m, size);
+        ::munmap(m, size);
+    }
+    ::close(fd);
+    key = (uint64_t{crc} << 32) | (size & 0xffffffffu);
+    return true;
+}
+
+std::string dataset_cache_path(const std::string& source, uint64_t key, const std::string& dir) {
+    namespace fs = std::filesystem;
+    const fs::path src(source);
+    const fs::path base = dir.empty() ? src.parent_path() : fs::path(dir);
+    return (base / fmt::format("{}.{:016x}.mdds", src.filename().string(), key)).string();
+}
+
+bool ColumnDataset::build(const std::string& source, const std::string& cache_path,
+                          uint64_t source_key, uint64_t source_size) {
+    EventFileReader reader(source);
+    if(!reader.ok()) {
+        log_error("ColumnDataset: failed to open '{}'", source);
+        return false;
+    }
+
+    std::vector<uint64_t> seq, ts;
+    std::vector<double> price;
+    std::vector<uint32_t> qty, symbol, aux;
+    std::vector<uint8_t> topic, kind;
+    std::vector<double> b_open, b_high, b_low, b_close;
+    std::vector<int32_t> b_volume;
+    std::vector<uint64_t> b_start, b_end;
+    std::vector<uint64_t> log_off{0};
+    std::string log_text;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+
+    auto id_of = [&](const std::string& s) {
+        auto [it, fresh] = ids.try_emplace(s, static_cast<uint32_t>(names.size()));
+        if(fresh) names.push_back(s);
+        return it->second;
+    };
+
+    Event e;
+    while(reader.next(e)) {
+        seq.push_back(e.h.seq);
+        ts.push_back(e.h.ts_ns);
+        topic.push_back(static_cast<uint8_t>(e.h.topic));
+        double px = 0.0;
+        uint32_t q = 0, sym = kNoSymbol, ax = 0;
+        PayloadKind k = PayloadKind::None;
+        if(const auto* t = std::get_if<Tick>(&e.p)) {
+            k = PayloadKind::Tick;
+            px = t->pq;
+            q = t->qty;
+            sym = id_of(t->symbol);
+        } else if(const auto* b = std::get_if<Bar>(&e.p)) {
+            k = PayloadKind::Bar;
+            sym = id_of(b->symbol);
+            ax = static_cast<uint32_t>(b_open.size());
+            b_open.push_back(b->open);
+            b_high.push_back(b->high);
+            b_low.push_back(b->low);
+            b_close.push_back(b->close);
+            b_volume.push_back(b->volume);
+            b_start.push_back(b->start_ts_ns);
+            b_end.push_back(b->end_ts_ns);
+        } else if(const auto* msg = std::get_if<std::string>(&e.p)) {
+            k = PayloadKind::Log;
+            ax = static_cast<uint32_t>(log_off.size() - 1);
+            log_text.append(*msg);
+            log_off.push_back(log_text.size());
+        }
+        price.push_back(px);
+        qty.push_back(q);
+        symbol.push_back(sym);
+        aux.push_back(ax);
+        kind.push_back(static_cast<uint8_t>(k));
+    }
+
+    DatasetCounts c;
+    c.rows = seq.size();
+    c.bars = b_open.size();
+    c.logs = log_off.size() - 1;
+    c.log_bytes = log_text.size();
+    c.symbols = static_cast<uint32_t>(names.size());
+    std::vector<uint32_t> sym_off{0};
+    std::string sym_text;
+    for(const auto& n : names) {
+        sym_text.append(n);
+        sym_off.push_back(static_cast<uint32_t>(sym_text.size()));
+    }
+    c.symbol_bytes = static_cast<uint32_t>(sym_text.size());
+
+    const DatasetLayout l(c);
+    std::string out(l.total, '\0');
+    std::memcpy(&out[0], kDatasetMagic, 4);
+    put_pod(out, 4, kDatasetVersion);
+    put_pod(out, 6, uint16_t{0});
+    put_pod(out, 8, source_size);
+    put_pod(out, 16, source_key);
+    put_pod(out, 24, c.rows);
+    put_pod(out, 32, c.bars);
+    put_pod(out, 40, c.logs);
+    put_pod(out, 48, c.log_bytes);
+    put_pod(out, 56, c.symbols);
+    put_pod(out, 60, c.symbol_bytes);
+    put_array(out, l.seq, seq);
+    put_array(out, l.ts, ts);
+    put_array(out, l.price, price);
+    put_array(out, l.qty, qty);
+    put_array(out, l.symbol, symbol);
+    put_array(out, l.aux, aux);
+    put_array(out, l.topic, topic);
+    put_array(out, l.kind, kind);
+    put_array(out, l.bar_open, b_open);
+    put_array(out, l.bar_high, b_high);
+    put_array(out, l.bar_low, b_low);
+    put_array(out, l.bar_close, b_close);
+    put_array(out, l.bar_volume, b_volume);
+    put_array(out, l.bar_start, b_start);
+    put_array(out, l.bar_end, b_end);
+    put_array(out, l.log_off, log_off);
+    if(!log_text.empty()) std::memcpy(&out[l.log_text], log_text.data(), log_text.size());
+    put_array(out, l.sym_off, sym_off);
+    if(!sym_text.empty()) std::memcpy(&out[l.sym_text], sym_text.data(), sym_text.size());
+
+    // Written aside and renamed into place, so a reader never maps a
+    // half-written cache.
+    const std::string tmp = cache_path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!f || !f.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+            log_error("ColumnDataset: failed to write '{}'", tmp);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, cache_path, ec);
+    if(ec) {
+        log_error("ColumnDataset: failed to rename '{}' to '{}': {}", tmp, cache_path, ec.message());
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    log_info("ColumnDataset: cached {} events of '{}' in '{}' ({} unreadable records skipped)",
+             c.rows, source, cache_path, reader.parse_errors());
+    return true;
+}
+
+ColumnDataset::~ColumnDataset() {
+    close();
+}
+
+void ColumnDataset::close() {
+    if(map_) ::munmap(const_cast<char*>(map_), map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+    rows_ = bars_ = 0;
+    symbols_.clear();
+}
+
+bool ColumnDataset::open(const std::string& source, const std::string& cache_dir) {
+    namespace fs = std::filesystem;
+    built_ = false;
+    uint64_t key = 0, size = 0;
+    if(!dataset_source_key(source, key, size)) {
+        MD_LOG_DEBUG("ColumnDataset: '{}' is not a readable file, not cached", source);
+        return false;
+    }
+    if(!cache_dir.empty()) {
+        std::error_code ec;
+        fs::create_directories(cache_dir, ec);
+    }
+    const std::string path = dataset_cache_path(source, key, cache_dir);
+    if(open_cache(path) && source_key_ == key) return true;
+
+    if(!build(source, path, key, size) || !open_cache(path)) return false;
+    built_ = true;
+
+    // Caches of earlier versions of the same log are dead weight now.
+    const fs::path p(path);
+    const std::string stem = fs::path(source).filename().string() + ".";
+    std::error_code ec;
+    for(const auto& ent : fs::directory_iterator(p.parent_path().empty() ? fs::path(".") : p.parent_path(), ec)) {
+        const std::string name = ent.path().filename().string();
+        if(name != p.filename().string() && name.size() == stem.size() + 16 + 5 &&
+           name.compare(0, stem.size(), stem) == 0 && ent.path().extension() == ".mdds") {
+            MD_LOG_DEBUG("ColumnDataset: removing stale cache '{}'", ent.path().string());
+            fs::remove(ent.path(), ec);
+        }
+    }
+    return true;
+}
+
+bool ColumnDataset::open_cache(const std::string& cache_path) {
+    close();
+    const int fd = ::open(cache_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return false;
+    struct stat st{};
+    if(::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < kDatasetHeaderSize) {
+        ::close(fd);
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(m == MAP_FAILED) {
+        log_warn("ColumnDataset: mmap of '{}' failed ({})", cache_path, std::strerror(errno));
+        return false;
+    }
+    map_ = static_cast<const char*>(m);
+    map_size_ = size;
+
+    DatasetCounts c;
+    if(std::memcmp(map_, kDatasetMagic, 4) != 0 || get_pod<uint16_t>(map_, 4) != kDatasetVersion) {
+        log_warn("ColumnDataset: '{}' is not a dataset cache (or an older version)", cache_path);
+        close();
+        return false;
+    }
+    source_key_ = get_pod<uint64_t>(map_, 16);
+    c.rows = get_pod<uint64_t>(map_, 24);
+    c.bars = get_pod<uint64_t>(map_, 32);
+    c.logs = get_pod<uint64_t>(map_, 40);
+    c.log_bytes = get_pod<uint64_t>(map_, 48);
+    c.symbols = get_pod<uint32_t>(map_, 56);
+    c.symbol_bytes = get_pod<uint32_t>(map_, 60);
+    const DatasetLayout l(c);
+    if(l.total != size) {
+        log_warn("ColumnDataset: '{}' is truncated or corrupt ({} bytes, expected {})",
+                 cache_path, size, l.total);
+        close();
+        return false;
+    }
+    ::madvise(const_cast<char*>(map_), size, MADV_WILLNEED);
+
+    cache_path_ = cache_path;
+    rows_ = c.rows;
+    bars_ = c.bars;
+    seq_ = reinterpret_cast<const uint64_t*>(map_ + l.seq);
+    ts_ = reinterpret_cast<const uint64_t*>(map_ + l.ts);
+    price_ = reinterpret_cast<const double*>(map_ + l.price);
+    qty_ = reinterpret_cast<const uint32_t*>(map_ + l.qty);
+    symbol_ = reinterpret_cast<const uint32_t*>(map_ + l.symbol);
+    aux_ = reinterpret_cast<const uint32_t*>(map_ + l.aux);
+    topic_ = reinterpret_cast<const uint8_t*>(map_ + l.topic);
+    kind_ = reinterpret_cast<const uint8_t*>(map_ + l.kind);
+    bar_open_ = reinterpret_cast<const double*>(map_ + l.bar_open);
+    bar_high_ = reinterpret_cast<const double*>(map_ + l.bar_high);
+    bar_low_ = reinterpret_cast<const double*>(map_ + l.bar_low);
+    bar_close_ = reinterpret_cast<const double*>(map_ + l.bar_close);
+    bar_volume_ = reinterpret_cast<const int32_t*>(map_ + l.bar_volume);
+    bar_start_ = reinterpret_cast<const uint64_t*>(map_ + l.bar_start);
+    bar_end_ = reinterpret_cast<const uint64_t*>(map_ + l.bar_end);
+    log_off_ = reinterpret_cast<const uint64_t*>(map_ + l.log_off);
+    log_text_ = map_ + l.log_text;
+
+    const auto* sym_off = reinterpret_cast<const uint32_t*>(map_ + l.sym_off);
+    symbols_.reserve(c.symbols);
+    for(uint32_t i = 0; i < c.symbols; ++i) {
+        symbols_.emplace_back(map_ + l.sym_text + sym_off[i], sym_off[i + 1] - sym_off[i]);
+    }
+    MD_LOG_DEBUG("ColumnDataset: mapped '{}' ({} rows, {} symbols)", cache_path, rows_, symbols_.size());
+    return true;
+}
+
+void ColumnDataset::event_at(std::size_t i, Event& e) const {
+    e.h.seq = seq_[i];
+    e.h.ts_ns = ts_[i];
+    e.h.topic = static_cast<Topic>(topic_[i]);
+    switch(static_cast<PayloadKind>(kind_[i])) {
+        case PayloadKind::Tick : {
+            Tick& t = emplace_reuse<Tick>(e.p);
+            t.symbol = symbols_[symbol_[i]];
+            t.pq = price_[i];
+            t.qty = qty_[i];
+            break;
+        }
+        case PayloadKind::Bar : {
+            const uint32_t b = aux_[i];
+            Bar& bar = emplace_reuse<Bar>(e.p);
+            bar.symbol = symbols_[symbol_[i]];
+            bar.open = bar_open_[b];
+            bar.high = bar_high_[b];
+            bar.low = bar_low_[b];
+            bar.close = bar_close_[b];
+            bar.volume = bar_volume_[b];
+            bar.start_ts_ns = bar_start_[b];
+            bar.end_ts_ns = bar_end_[b];
+            break;
+        }
+        case PayloadKind::Log : {
+            emplace_reuse<std::string>(e.p).assign(log_text(aux_[i]));
+            break;
+        }
+        default : {
+            e.p = std::monostate{};
+            break;
+        }
+    }
+}
+
+std::size_t ColumnDataset::first_row(const ReplayStart& start) const {
+    switch(start.from) {
+        case ReplayStart::From::Beginning :
+            return 0;
+        case ReplayStart::From::Seq :
+            return static_cast<std::size_t>(std::lower_bound(seq_, seq_ + rows_, start.seq) - seq_);
+        case ReplayStart::From::Ts :
+            return static_cast<std::size_t>(std::lower_bound(ts_, ts_ + rows_, start.ts_ns) - ts_);
+        case ReplayStart::From::After : {
+            auto i = static_cast<std::size_t>(std::lower_bound(ts_, ts_ + rows_, start.ts_ns) - ts_);
+            while(i < rows_ && ts_[i] == start.ts_ns && seq_[i] <= start.seq) ++i;
+            return i;
+        }
+    }
+    return 0;
+}
+
+uint64_t scan_dataset(const ColumnDataset& d, const ReplayFilter& f,
+                      const std::function<bool(Event&)>& fn, const ReplayStart& start) {
+    Event e;
+    return for_each_row(d, f, start, [&](std::size_t i) {
+        d.event_at(i, e);
+        return fn(e);
+    });
+}
+
+}
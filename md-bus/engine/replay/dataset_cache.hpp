@@ -0,0 +1,188 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/event.hpp"
+#include "../common/event_binary.hpp"
+#include "../common/event_filter.hpp"
+#include "replay.hpp"
+
+namespace md {
+
+// --- Dataset cache file ---
+//
+// A recording decoded once into fixed-width columns, laid out so that a
+// read-only mapping of the file is usable as is. Host byte order: a cache
+// is a local artifact of the machine that built it, never an archive.
+//
+//   header (64 bytes)
+//     char magic[4] "MDDS" | u16 version | u16 flags (0)
+//     u64 source_size | u64 source_key
+//     u64 rows | u64 bars | u64 logs | u64 log_bytes
+//     u32 symbols | u32 symbol_bytes
+//   per row:  u64 seq[rows] | u64 ts[rows] | f64 price[rows] | u32 qty[rows]
+//             | u32 symbol[rows] | u32 aux[rows] | u8 topic[rows] | u8 kind[rows]
+//   per bar:  f64 open, high, low, close[bars] | i32 volume[bars]
+//             | u64 start_ts[bars] | u64 end_ts[bars]
+//   logs:     u64 offset[logs + 1] | char text[log_bytes]
+//   symbols:  u32 offset[symbols + 1] | char name[symbol_bytes]
+//
+// Every array starts on an 8-byte boundary. kind is the PayloadKind of
+// the row; price / qty are set for Tick rows, symbol for Tick and Bar rows
+// (kNoSymbol otherwise, ids in first-seen order), aux is the row's index
+// into the bar or log arrays. source_key identifies the source contents
+// (dataset_source_key) and is also part of the cache file name.
+
+inline constexpr char kDatasetMagic[4] = {'M', 'D', 'D', 'S'};
+inline constexpr uint16_t kDatasetVersion = 1;
+inline constexpr std::size_t kDatasetHeaderSize = 64;
+
+// Key of a source log: CRC32C of its contents in the high half, the low
+// half of its size in the low one. False if it cannot be read (or is a
+// journal directory).
+bool dataset_source_key(const std::string& source, uint64_t& key, uint64_t& size);
+
+// <dir>/<source file name>.<key as 16 hex digits>.mdds; dir "" is the
+// source's own directory.
+std::string dataset_cache_path(const std::string& source, uint64_t key,
+                               const std::string& dir = "");
+
+/*
+ * ColumnDataset
+ * -------------
+ * A recording as columns (see the file layout above), mapped from its
+ * cache file:
+ *
+ *   md::ColumnDataset d;
+ *   if (d.open("logs/md_events.log", "cache/")) {
+ *       for (std::size_t i = 0; i < d.size(); ++i) use(d.ts()[i], d.price()[i]);
+ *   }
+ *
+ * open() hashes the source and maps the cache built from exactly those
+ * bytes; if there is none (first run, or the log changed) it decodes the
+ * log once, writes the cache and removes stale caches of the same log.
+ * After that no run parses the log again: readers index the columns
+ * directly and event_at() materializes an Event only where one is needed.
+ *
+ * Read-only once open; threads may share one dataset.
+ */
+class ColumnDataset {
+public :
+    static constexpr uint32_t kNoSymbol = UINT32_MAX;
+
+    ColumnDataset() = default;
+    ~ColumnDataset();
+    ColumnDataset(const ColumnDataset&) = delete;
+    ColumnDataset& operator=(const ColumnDataset&) = delete;
+
+    // Maps the up-to-date cache of source, building it first if needed.
+    bool open(const std::string& source, const std::string& cache_dir = "");
+
+    // Maps an existing cache file without checking it against its source.
+    bool open_cache(const std::string& cache_path);
+
+    // Decodes source (any format EventFileReader reads) into cache_path.
+    static bool build(const std::string& source, const std::string& cache_path,
+                      uint64_t source_key, uint64_t source_size);
+
+    bool ok() const { return map_ != nullptr; }
+    // True if the last open() had to decode the source.
+    bool built() const { return built_; }
+    const std::string& cache_path() const { return cache_path_; }
+    uint64_t source_key() const { return source_key_; }
+
+    std::size_t size() const { return rows_; }
+    const uint64_t* seq() const { return seq_; }
+    const uint64_t* ts() const { return ts_; }
+    const double* price() const { return price_; }
+    const uint32_t* qty() const { return qty_; }
+    const uint32_t* symbol() const { return symbol_; }
+    const uint32_t* aux() const { return aux_; }
+    const uint8_t* topic() const { return topic_; }
+    const uint8_t* kind() const { return kind_; }
+
+    std::size_t bars() const { return bars_; }
+    const double* bar_open() const { return bar_open_; }
+    const double* bar_high() const { return bar_high_; }
+    const double* bar_low() const { return bar_low_; }
+    const double* bar_close() const { return bar_close_; }
+    const int32_t* bar_volume() const { return bar_volume_; }
+    const uint64_t* bar_start_ts() const { return bar_start_; }
+    const uint64_t* bar_end_ts() const { return bar_end_; }
+
+    const std::vector<std::string>& symbols() const { return symbols_; }
+    std::string_view log_text(std::size_t log) const {
+        return std::string_view(log_text_ + log_off_[log], log_off_[log + 1] - log_off_[log]);
+    }
+
+    // Row i as an Event; e's strings keep their capacity (emplace_reuse).
+    void event_at(std::size_t i, Event& e) const;
+
+    // True if row i passes pre, judged on the columns alone.
+    bool admits(std::size_t i, const EventPrefilter& pre) const {
+        if(!pre.admits_header(ts_[i], static_cast<Topic>(topic_[i]))) return false;
+        if(!pre.by_symbol()) return true;
+        return kind_[i] == static_cast<uint8_t>(PayloadKind::Tick) &&
+               pre.admits_symbol_id(symbol_[i], symbols_);
+    }
+
+    // First row a scan from start visits (binary search on the ts / seq
+    // columns, which a recording keeps ascending).
+    std::size_t first_row(const ReplayStart& start) const;
+
+private :
+    const char* map_{nullptr};
+    std::size_t map_size_{0};
+    std::string cache_path_;
+    bool built_{false};
+    uint64_t source_key_{0};
+
+    std::size_t rows_{0}, bars_{0};
+    const uint64_t* seq_{nullptr};
+    const uint64_t* ts_{nullptr};
+    const double* price_{nullptr};
+    const uint32_t* qty_{nullptr};
+    const uint32_t* symbol_{nullptr};
+    const uint32_t* aux_{nullptr};
+    const uint8_t* topic_{nullptr};
+    const uint8_t* kind_{nullptr};
+    const double* bar_open_{nullptr};
+    const double* bar_high_{nullptr};
+    const double* bar_low_{nullptr};
+    const double* bar_close_{nullptr};
+    const int32_t* bar_volume_{nullptr};
+    const uint64_t* bar_start_{nullptr};
+    const uint64_t* bar_end_{nullptr};
+    const uint64_t* log_off_{nullptr};
+    const char* log_text_{nullptr};
+    std::vector<std::string> symbols_;
+
+    void close();
+};
+
+// Calls fn(row) for every row of d from start that matches f (max_events
+// aside), until fn returns false. Returns the rows matched. Rows with
+// ts_ns == 0 are skipped, as scan_events skips them.
+template <typename F>
+uint64_t for_each_row(const ColumnDataset& d, const ReplayFilter& f,
+                      const ReplayStart& start, F&& fn) {
+    const EventPrefilter pre = prefilter_for(f);
+    const uint64_t* ts = d.ts();
+    uint64_t matched = 0;
+    for(std::size_t i = d.first_row(start); i < d.size(); ++i) {
+        if(ts[i] == 0 || !d.admits(i, pre)) continue;
+        ++matched;
+        if(!fn(i)) break;
+    }
+    return matched;
+}
+
+// scan_events over a dataset.
+uint64_t scan_dataset(const ColumnDataset& d, const ReplayFilter& f,
+                      const std::function<bool(Event&)>& fn,
+                      const ReplayStart& start = {});
+
+}
@@ -0,0 +1,501 @@
+#include "event_reader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/byte_scan.hpp"
+#include "../common/event_index.hpp"
+#include "../common/event_io.hpp"
+#include "../common/log.hpp"
+
+namespace md {
+
+static constexpr std::size_t kReadChunk = 1 << 20;
+
+static uint64_t page_floor(uint64_t off) {
+    static const uint64_t page = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    return off - off % page;
+}
+
+EventFileReader::EventFileReader(const std::string& path, const EventReaderConfig& cfg)
+    : path_{path}, cfg_{cfg} {
+    std::error_code ec;
+    if(std::filesystem::is_directory(path_, ec)) {
+        journal_ = std::make_unique<JournalReader>(path_);
+        format_ = RecordFormat::Binary;
+        ok_ = true;
+        return;
+    }
+
+    in_.open(path_, std::ios::in | std::ios::binary);
+    if(!in_) {
+        log_error("EventFileReader: failed to open '{}'", path_);
+        return;
+    }
+
+    char head[kBinaryFileHeaderSize];
+    in_.read(head, sizeof(head));
+    const auto got = static_cast<std::size_t>(in_.gcount());
+
+    uint16_t flags = 0;
+    std::size_t data_start = 0;
+    if(looks_like_columnar_log(std::string_view(head, got))) {
+        if(!read_columnar_file_header(std::string_view(head, got), flags)) {
+            log_error("EventFileReader: '{}' has an unsupported columnar header", path_);
+            return;
+        }
+        format_ = RecordFormat::Columnar;
+        checksums_ = (flags & kBinaryFlagChecksummed) != 0;
+        next_block_off_ = kBinaryFileHeaderSize;
+        data_start = kBinaryFileHeaderSize;
+    } else if(looks_like_binary_log(std::string_view(head, got))) {
+        if(!read_binary_file_header(std::string_view(head, got), flags)) {
+            log_error("EventFileReader: '{}' has an unsupported binary header", path_);
+            return;
+        }
+        format_ = RecordFormat::Binary;
+        zero_terminated_ = (flags & kBinaryFlagZeroTerminated) != 0;
+        checksums_ = (flags & kBinaryFlagChecksummed) != 0;
+        bin_.set_checksums(checksums_);
+        data_start = kBinaryFileHeaderSize;
+    } else {
+        format_ = RecordFormat::Text;
+    }
+
+    data_start_ = data_start;
+    if(cfg_.use_mmap && map_file()) {
+        in_.close();
+        base_ = map_;
+        len_ = map_size_;
+        pos_ = data_start;
+    } else {
+        in_.clear();
+        in_.seekg(static_cast<std::streamoff>(data_start));
+        if(format_ != RecordFormat::Columnar) {
+            buf_.resize(kReadChunk);
+            base_ = buf_.data();
+            buf_off_ = data_start;
+        }
+    }
+    ok_ = true;
+}
+
+EventFileReader::~EventFileReader() {
+    if(map_) ::munmap(const_cast<char*>(map_), map_size_);
+    if(fd_ >= 0) ::close(fd_);
+}
+
+// Maps the whole file read-only. False (stream reads instead) if it is
+// empty or cannot be mapped.
+bool EventFileReader::map_file() {
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if(fd_ < 0 || ::fstat(fd_, &st) != 0 || st.st_size == 0) {
+        if(fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+    if(m == MAP_FAILED) {
+        MD_LOG_DEBUG("EventFileReader: mmap of '{}' failed ({}), using reads", path_, std::strerror(errno));
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    map_ = static_cast<const char*>(m);
+    map_size_ = size;
+    ::madvise(m, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+// Re-maps a file that has grown since it was mapped (a recorder still
+// appending to it). True if there is new data.
+bool EventFileReader::remap() {
+    struct stat st{};
+    if(::fstat(fd_, &st) != 0 || static_cast<std::size_t>(st.st_size) <= map_size_) return false;
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* m = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+    if(m == MAP_FAILED) return false;
+    ::munmap(const_cast<char*>(map_), map_size_);
+    map_ = static_cast<const char*>(m);
+    map_size_ = size;
+    ::madvise(m, size, MADV_SEQUENTIAL);
+    base_ = map_;
+    len_ = map_size_;
+    released_ = 0; // the new mapping starts out unpopulated
+    advised_ = 0;
+    return true;
+}
+
+// Keeps readahead_bytes ahead of the cursor requested (MADV_WILLNEED) and
+// unmaps what lies more than that far behind it, so a long replay neither
+// stalls on page faults nor grows its resident set with the file.
+void EventFileReader::advise_window() {
+    const uint64_t ra = cfg_.readahead_bytes;
+    if(ra == 0) return;
+    const uint64_t cur = offset();
+    if(cur + ra / 2 >= advised_ && advised_ < map_size_) {
+        const uint64_t from = page_floor(std::max(cur, advised_));
+        const uint64_t to = std::min<uint64_t>(map_size_, cur + ra);
+        if(to > from) ::madvise(const_cast<char*>(map_) + from, to - from, MADV_WILLNEED);
+        advised_ = to;
+    }
+    if(cur > released_ + 2 * ra) {
+        const uint64_t upto = page_floor(cur - ra);
+        ::madvise(const_cast<char*>(map_) + released_, upto - released_, MADV_DONTNEED);
+        if(cfg_.drop_behind) {
+            ::posix_fadvise(fd_, static_cast<off_t>(released_), static_cast<off_t>(upto - released_),
+                            POSIX_FADV_DONTNEED);
+        }
+        released_ = upto;
+    }
+}
+
+bool EventFileReader::next(Event& out) {
+    if(!ok_) return false;
+    if(has_pending_) {
+        std::swap(out, pending_);
+        has_pending_ = false;
+        return true;
+    }
+    if(journal_) {
+        if(!journal_->next(out)) return false;
+        ++records_;
+        return true;
+    }
+    bool got = false;
+    switch(format_) {
+        case RecordFormat::Text : got = next_text(out); break;
+        case RecordFormat::Binary : got = next_binary(out); break;
+        case RecordFormat::Columnar : got = next_columnar(out); break;
+    }
+    if(got && map_) advise_window();
+    return got;
+}
+
+void EventFileReader::set_symbols(std::vector<std::string> symbols) {
+    if(format_ == RecordFormat::Columnar) col_.set_symbols(std::move(symbols));
+    else bin_.set_symbols(std::move(symbols));
+}
+
+void EventFileReader::set_prefilter(const EventPrefilter& pre) {
+    pre_ = pre;
+    prefilter_ = pre_.active();
+    bin_.set_prefilter(prefilter_ ? &pre_ : nullptr);
+}
+
+uint64_t EventFileReader::offset() const {
+    switch(format_) {
+        case RecordFormat::Text :
+        case RecordFormat::Binary : return buf_off_ + pos_;
+        case RecordFormat::Columnar :
+            // a block counts as unread until its last event is handed out
+            return batch_pos_ < batch_.size() ? block_off_ : next_block_off_;
+    }
+    return 0;
+}
+
+bool EventFileReader::seek(uint64_t offset) {
+    if(!ok_ || journal_) return false;
+    if(map_) {
+        released_ = std::min(released_, page_floor(offset));
+        advised_ = offset;
+    } else {
+        in_.clear();
+        in_.seekg(static_cast<std::streamoff>(offset));
+        if(!in_) {
+            log_error("EventFileReader: cannot seek to {} in '{}'", offset, path_);
+            return false;
+        }
+    }
+    has_pending_ = false;
+    resync_line_ = false;
+    if(format_ == RecordFormat::Columnar) {
+        batch_.clear();
+        batch_pos_ = 0;
+        next_block_off_ = offset;
+        return true;
+    }
+    if(format_ == RecordFormat::Binary) bin_.restart(); // offset starts with a SYNC
+    if(map_) {
+        pos_ = offset; // buf_off_ stays 0: the mapping is the whole file
+    } else {
+        pos_ = 0;
+        len_ = 0;
+        buf_off_ = offset;
+        eof_ = false;
+    }
+    return true;
+}
+
+bool EventFileReader::next_text(Event& out) {
+    for(;;) {
+        const char* begin = base_ + pos_;
+        const char* end = base_ + len_;
+        const char* nl = find_byte(begin, end, '\n');
+        if(nl == end) {
+            // partial line: pull in more, or take it as the last line
+            if(refill()) continue;
+            if(pos_ >= len_) return false;
+        }
+        if(resync_line_) {
+            // landed mid-line after a seek: drop up to the next newline
+            if(nl == end) return false;
+            pos_ += static_cast<std::size_t>(nl - begin) + 1;
+            resync_line_ = false;
+            continue;
+        }
+        const std::string_view line(begin, static_cast<std::size_t>(nl - begin));
+        record_off_ = buf_off_ + pos_;
+        pos_ += line.size() + (nl != end);
+        ++records_;
+        if(line.empty()) continue;
+        if(prefilter_ && !pre_.admits_line(line)) {
+            ++filtered_;
+            continue;
+        }
+        if(!parse_event(line, out)) {
+            ++parse_errors_;
+            if(on_error_) on_error_(records_, line);
+            else log_warn("EventReplay: failed to parse line: {}", line);
+            continue;
+        }
+        return true;
+    }
+}
+
+// Makes more data available after len_: a re-map for mapped files, else
+// moves the unread tail to the front of buf_ and appends the next chunk.
+bool EventFileReader::refill() {
+    if(map_) return remap();
+    if(eof_) return false;
+    if(pos_ > 0) {
+        std::memmove(buf_.data(), buf_.data() + pos_, len_ - pos_);
+        len_ -= pos_;
+        buf_off_ += pos_;
+        pos_ = 0;
+    }
+    if(len_ == buf_.size()) buf_.resize(buf_.size() * 2); // record larger than a chunk
+    base_ = buf_.data();
+    in_.read(buf_.data() + len_, static_cast<std::streamsize>(buf_.size() - len_));
+    const auto got = static_cast<std::size_t>(in_.gcount());
+    len_ += got;
+    if(got == 0 || !in_) eof_ = true;
+    return got > 0;
+}
+
+bool EventFileReader::next_binary(Event& out) {
+    for(;;) {
+        if(zero_terminated_) {
+            if(pos_ >= len_ && !refill()) return false;
+            if(base_[pos_] == 0) return false; // end of a pre-allocated segment
+        }
+        if(pos_ > len_) return false; // seeked past the end
+        const uint64_t at = buf_off_ + pos_;
+        std::size_t used = 0;
+        const DecodeStatus st = bin_.decode(base_ + pos_, base_ + len_, out, used);
+        pos_ += used;
+        switch(st) {
+            case DecodeStatus::Event :
+                record_off_ = at + bin_.event_at();
+                ++records_;
+                return true;
+            case DecodeStatus::End :
+            case DecodeStatus::Truncated :
+                if(refill()) continue;
+                if(st == DecodeStatus::Truncated) {
+                    log_warn("EventFileReader: '{}' ends with a truncated record ({} bytes ignored)",
+                             path_, len_ - pos_);
+                }
+                return false;
+            case DecodeStatus::Corrupt :
+                ++parse_errors_;
+                if(on_error_) on_error_(records_ + 1, std::string_view{});
+                log_error("EventFileReader: corrupt record after {} events in '{}', stopping",
+                          records_, path_);
+                return false;
+        }
+    }
+}
+
+// Locates the block at next_block_off_: header fields, and a body pointer
+// with kColumnPad readable bytes after it (in the mapping when the file
+// has that much slack, else copied into block_). Event = loaded, Corrupt =
+// checksum mismatch.
+DecodeStatus EventFileReader::load_column_block(const char*& body, uint32_t& body_bytes,
+                                                uint32_t& n_events) {
+    const std::size_t crc_bytes = checksums_ ? kRecordChecksumSize : 0;
+    char hdr[kColumnBlockHeaderSize];
+
+    if(map_) {
+        auto avail = [&] { return map_size_ > next_block_off_ ? map_size_ - next_block_off_ : 0; };
+        if(avail() < kColumnBlockHeaderSize) remap();
+        if(avail() == 0) return DecodeStatus::End;
+        if(avail() < kColumnBlockHeaderSize) return DecodeStatus::Truncated;
+        const char* p = map_ + next_block_off_;
+        std::memcpy(hdr, p, sizeof(hdr));
+        read_column_block_header(hdr, body_bytes, n_events);
+        const std::size_t total = kColumnBlockHeaderSize + body_bytes + crc_bytes;
+        if(avail() < total && (!remap() || avail() < total)) return DecodeStatus::Truncated;
+        p = map_ + next_block_off_; // remap() may have moved the mapping
+        if(avail() >= total + kColumnPad) {
+            body = p + kColumnBlockHeaderSize;
+        } else {
+            block_.assign(p + kColumnBlockHeaderSize, p + kColumnBlockHeaderSize + body_bytes);
+            block_.resize(body_bytes + kColumnPad, '\0');
+            body = block_.data();
+        }
+        if(crc_bytes && get_u32(p + kColumnBlockHeaderSize + body_bytes) !=
+                            crc32c(p, kColumnBlockHeaderSize + body_bytes)) {
+            return DecodeStatus::Corrupt;
+        }
+        return DecodeStatus::Event;
+    }
+
+    in_.read(hdr, sizeof(hdr));
+    const auto got = static_cast<std::size_t>(in_.gcount());
+    if(got == 0) return DecodeStatus::End;
+    if(got != sizeof(hdr)) return DecodeStatus::Truncated;
+    read_column_block_header(hdr, body_bytes, n_events);
+    block_.resize(body_bytes + std::max(kColumnPad, crc_bytes));
+    in_.read(block_.data(), static_cast<std::streamsize>(body_bytes + crc_bytes));
+    if(static_cast<std::size_t>(in_.gcount()) != body_bytes + crc_bytes) return DecodeStatus::Truncated;
+    bool intact = true;
+    if(crc_bytes) {
+        intact = get_u32(block_.data() + body_bytes) ==
+                 crc32c(block_.data(), body_bytes, crc32c(hdr, sizeof(hdr)));
+    }
+    std::memset(block_.data() + body_bytes, 0, kColumnPad);
+    body = block_.data();
+    return intact ? DecodeStatus::Event : DecodeStatus::Corrupt;
+}
+
+bool EventFileReader::next_columnar(Event& out) {
+    while(batch_pos_ >= batch_.size()) {
+        const char* body = nullptr;
+        uint32_t body_bytes = 0, n_events = 0;
+        const DecodeStatus st = load_column_block(body, body_bytes, n_events);
+        if(st == DecodeStatus::End) return false;
+        if(st == DecodeStatus::Truncated) {
+            log_warn("EventFileReader: '{}' ends with a truncated block", path_);
+            return false;
+        }
+
+        block_off_ = next_block_off_;
+        next_block_off_ += kColumnBlockHeaderSize + body_bytes + (checksums_ ? kRecordChecksumSize : 0);
+        record_off_ = block_off_;
+        batch_pos_ = 0;
+        if(st == DecodeStatus::Corrupt ||
+           !col_.decode_block(body, body_bytes, n_events, batch_, prefilter_ ? &pre_ : nullptr)) {
+            batch_.clear();
+            ok_ = false;
+            ++parse_errors_;
+            if(on_error_) on_error_(records_ + 1, std::string_view{});
+            log_error("EventFileReader: corrupt block at offset {} in '{}', stopping",
+                      block_off_, path_);
+            return false;
+        }
+        filtered_ += n_events - batch_.size();
+    }
+    // swap rather than copy: the caller's old event becomes reusable storage
+    std::swap(out, batch_[batch_pos_++]);
+    ++records_;
+    return true;
+}
+
+// --- seeking by key ---
+
+// First event at or after offset (a record boundary, or for text any byte:
+// the partial line there is skipped), without the prefilter.
+bool EventFileReader::probe(uint64_t offset, bool mid_line, Event& out) {
+    if(!seek(offset)) return false;
+    resync_line_ = mid_line;
+    const bool filtered = prefilter_;
+    bin_.set_prefilter(nullptr);
+    prefilter_ = false;
+    const bool got = next(out);
+    prefilter_ = filtered;
+    bin_.set_prefilter(filtered ? &pre_ : nullptr);
+    return got;
+}
+
+// Picks a start offset at or before the first event whose key reaches
+// target, then reads forward to it and keeps it as the pending event.
+bool EventFileReader::seek_to_key(uint64_t target, bool by_seq) {
+    if(!ok_) return false;
+    auto key = [by_seq](const Event& e) { return by_seq ? e.h.seq : e.h.ts_ns; };
+    Event e;
+    has_pending_ = false;
+
+    uint64_t start = data_start_;
+    EventIndex idx;
+    if(journal_) {
+        // no random access: continue from the current position
+    } else if(idx.load_for(path_) && idx.format() == format_ && !idx.blocks().empty()) {
+        const auto& blocks = idx.blocks();
+        if(format_ != RecordFormat::Text) {
+            const auto& known = format_ == RecordFormat::Columnar ? col_.symbols() : bin_.symbols();
+            if(idx.symbols().size() > known.size()) set_symbols(idx.symbols());
+        }
+        // last block whose first key is below target (equal keys may
+        // straddle a block boundary)
+        std::size_t lo = 0, hi = blocks.size();
+        while(hi - lo > 1) {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            uint64_t first = 0;
+            if(by_seq) {
+                if(!probe(blocks[mid].offset, false, e)) break;
+                first = key(e);
+            } else {
+                first = blocks[mid].ts_min;
+            }
+            if(first < target) lo = mid;
+            else hi = mid;
+        }
+        start = blocks[lo].offset;
+        MD_LOG_DEBUG("EventFileReader: index seek to block {} of {} in '{}'", lo, blocks.size(), path_);
+    } else if(format_ == RecordFormat::Text) {
+        // Binary search over byte offsets: a probe reads the first whole
+        // line after the offset. lo is always a line start before target.
+        static constexpr uint64_t kLinearBytes = 64u << 10;
+        std::error_code ec;
+        uint64_t lo = data_start_;
+        uint64_t hi = map_ ? map_size_ : std::filesystem::file_size(path_, ec);
+        while(!ec && hi - lo > kLinearBytes) {
+            const uint64_t mid = lo + (hi - lo) / 2;
+            if(probe(mid, true, e) && key(e) < target) lo = record_off_;
+            else hi = mid;
+        }
+        start = lo;
+    } else {
+        MD_LOG_DEBUG("EventFileReader: no index for '{}', seeking by a linear scan", path_);
+    }
+
+    if(!journal_ && !seek(start)) return false;
+    while(next(e)) {
+        if(key(e) >= target) {
+            std::swap(pending_, e);
+            has_pending_ = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EventFileReader::seek_to_ts(uint64_t ts_ns) {
+    return seek_to_key(ts_ns, false);
+}
+
+bool EventFileReader::seek_to_seq(uint64_t seq) {
+    return seek_to_key(seq, true);
+}
+
+}
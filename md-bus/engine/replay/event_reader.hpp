@@ -0,0 +1,170 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/event.hpp"
+#include "../common/column_codec.hpp"
+#include "../common/event_binary.hpp"
+#include "../common/event_filter.hpp"
+#include "../record/journal.hpp"
+
+namespace md {
+
+/*
+ * EventFileReader
+ * ---------------
+ * Pull-based reader for recorded event logs. The format (text CSV, binary
+ * or columnar) is detected from the first bytes of the file; a directory is
+ * read as a segmented journal (record/journal.hpp).
+ *
+ *   md::EventFileReader r("logs/md_events.log");
+ *   md::Event e;
+ *   while (r.next(e)) { ... }
+ *
+ * Files are memory-mapped (MADV_SEQUENTIAL) and decoded in place: text
+ * lines are found with find_byte (common/byte_scan.hpp) and parsed
+ * straight out of the mapping, columnar blocks are unpacked from it. A
+ * window ahead of the cursor is prefetched and pages behind it released,
+ * see EventReaderConfig. If mapping fails the reader falls back to 1 MiB
+ * chunked reads with the same parsing.
+ *
+ * Unparseable text lines are skipped and counted; the optional error
+ * handler sees each one (the view is only valid during the call). A torn binary tail (crash mid-write) ends the
+ * stream with a warning.
+ *
+ * With set_prefilter(), records failing the filter are dropped before their
+ * payload is decoded (common/event_filter.hpp). Journal directories are
+ * not prefiltered; callers that need exact results still check admits().
+ */
+struct EventReaderConfig {
+    // Map the file and parse in place instead of reading through a buffer.
+    bool use_mmap{true};
+    // Prefetched ahead of the cursor (MADV_WILLNEED); pages more than this
+    // far behind it are unmapped (MADV_DONTNEED). 0 leaves both to the kernel.
+    std::size_t readahead_bytes{32u << 20};
+    // Also evict released pages from the page cache (POSIX_FADV_DONTNEED):
+    // for one-pass replays of archives larger than RAM, at the cost of
+    // re-reading from disk if the same file is replayed again.
+    bool drop_behind{false};
+};
+
+class EventFileReader {
+public :
+    using ErrorHandler = std::function<void(uint64_t record_no, std::string_view raw)>;
+
+    explicit EventFileReader(const std::string& path, const EventReaderConfig& cfg = {});
+    ~EventFileReader();
+
+    EventFileReader(const EventFileReader&) = delete;
+    EventFileReader& operator=(const EventFileReader&) = delete;
+
+    bool ok() const { return ok_; }
+    RecordFormat format() const { return format_; }
+    const std::string& path() const { return path_; }
+
+    // Next event in file order; false at end of file.
+    bool next(Event& out);
+
+    // Byte offset of the next unread record / of the record next() returned
+    // last. Not meaningful for journal directories.
+    uint64_t offset() const;
+    uint64_t record_offset() const { return record_off_; }
+
+    // Repositions at a record boundary, e.g. an index block offset. For
+    // binary logs the offset must start with a SYNC record and the symbol
+    // table must be known (set_symbols), as the .idx sidecar provides.
+    bool seek(uint64_t offset);
+    void set_symbols(std::vector<std::string> symbols);
+
+    // Positions the reader so that next() returns the first event with
+    // ts_ns / seq at or above the target, assuming the log is in that
+    // order. Binary search over the .idx blocks when there is an index,
+    // else over line offsets for text; binary and columnar logs without an
+    // index are scanned from the start, journals from the current
+    // position. False (and at the end) if no event reaches the target.
+    bool seek_to_ts(uint64_t ts_ns);
+    bool seek_to_seq(uint64_t seq);
+    bool is_journal() const { return journal_ != nullptr; }
+    bool mapped() const { return map_ != nullptr; }
+
+    uint64_t records() const { return records_; }
+    uint64_t parse_errors() const { return parse_errors_; }
+
+    void set_error_handler(ErrorHandler h) { on_error_ = std::move(h); }
+
+    // Applies to records read from now on; an inactive filter turns it off.
+    void set_prefilter(const EventPrefilter& pre);
+    // Records dropped by the prefilter so far.
+    uint64_t filtered() const { return filtered_ + bin_.filtered(); }
+
+private :
+    std::string path_;
+    EventReaderConfig cfg_;
+    std::ifstream in_;
+    bool ok_{false};
+    RecordFormat format_{RecordFormat::Text};
+
+    uint64_t records_{0};
+    uint64_t parse_errors_{0};
+    uint64_t record_off_{0};
+    ErrorHandler on_error_;
+
+    EventPrefilter pre_;
+    bool prefilter_{false};
+    uint64_t filtered_{0};     // text lines and columnar rows
+
+    uint64_t data_start_{0};   // offset of the first record
+    Event pending_;            // found by seek_to_*, returned by next()
+    bool has_pending_{false};
+    bool resync_line_{false};  // text: skip to the next newline first
+
+    // mapped file (cfg_.use_mmap)
+    int fd_{-1};
+    const char* map_{nullptr};
+    std::size_t map_size_{0};
+    uint64_t advised_{0};     // WILLNEED issued up to here
+    uint64_t released_{0};    // DONTNEED issued below here (page aligned)
+
+    // text and binary: base_[pos_, len_) is the data at file offset
+    // buf_off_ + pos_, either the mapping or chunked reads into buf_
+    const char* base_{nullptr};
+    std::vector<char> buf_;
+    std::size_t pos_{0};
+    std::size_t len_{0};
+    uint64_t buf_off_{0};     // file offset of buf_[0]
+    bool eof_{false};
+
+    // binary
+    BinaryEventReader bin_;
+    bool zero_terminated_{false};
+    bool checksums_{false};   // binary / columnar kBinaryFlagChecksummed
+
+    // columnar
+    ColumnBlockDecoder col_;
+    std::vector<Event> batch_;
+    std::size_t batch_pos_{0};
+    std::vector<char> block_;
+    uint64_t block_off_{0};       // offset of the block batch_ came from
+    uint64_t next_block_off_{0};
+
+    // journal directory
+    std::unique_ptr<JournalReader> journal_;
+
+    bool next_text(Event& out);
+    bool next_binary(Event& out);
+    bool next_columnar(Event& out);
+    bool refill();
+    bool map_file();
+    bool remap();
+    void advise_window();
+    DecodeStatus load_column_block(const char*& body, uint32_t& body_bytes, uint32_t& n_events);
+    bool probe(uint64_t offset, bool mid_line, Event& out);
+    bool seek_to_key(uint64_t target, bool by_seq);
+};
+
+}
@@ -0,0 +1,77 @@
+#include "merged_reader.hpp"
+
+#include <algorithm>
+#include <functional>
+
+#include "../common/log.hpp"
+
+namespace md {
+
+MergedEventReader::MergedEventReader(const std::vector<std::string>& paths,
+                                     const EventReaderConfig& input_cfg,
+                                     const EventPrefilter& pre) {
+    ok_ = true;
+    readers_.reserve(paths.size());
+    heads_.resize(paths.size());
+    heap_.reserve(paths.size());
+    for(const auto& p : paths) {
+        readers_.push_back(std::make_unique<EventFileReader>(p, input_cfg));
+        if(!readers_.back()->ok()) {
+            log_error("MergedEventReader: failed to open '{}'", p);
+            ok_ = false;
+        }
+        readers_.back()->set_prefilter(pre);
+    }
+    if(!ok_) return;
+    for(std::size_t i = 0; i < readers_.size(); ++i) push(i);
+    MD_LOG_DEBUG("MergedEventReader: merging {} inputs", readers_.size());
+}
+
+// Reads input's next event into its head slot and enters it into the heap.
+void MergedEventReader::push(std::size_t input) {
+    Event& e = heads_[input];
+    if(!readers_[input]->next(e)) return;
+    heap_.push_back(Head{e.h.ts_ns, e.h.seq, input});
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<Head>{});
+}
+
+bool MergedEventReader::next(Event& out) {
+    if(heap_.empty()) return false;
+    std::pop_heap(heap_.begin(), heap_.end(), std::greater<Head>{});
+    source_ = heap_.back().input;
+    heap_.pop_back();
+    std::swap(out, heads_[source_]);
+    push(source_);
+    return true;
+}
+
+bool MergedEventReader::seek_to_key(uint64_t target, bool by_seq) {
+    heap_.clear();
+    for(std::size_t i = 0; i < readers_.size(); ++i) {
+        auto& r = *readers_[i];
+        if(by_seq ? r.seek_to_seq(target) : r.seek_to_ts(target)) push(i);
+    }
+    return !heap_.empty();
+}
+
+bool MergedEventReader::seek_to_ts(uint64_t ts_ns) {
+    return seek_to_key(ts_ns, false);
+}
+
+bool MergedEventReader::seek_to_seq(uint64_t seq) {
+    return seek_to_key(seq, true);
+}
+
+uint64_t MergedEventReader::records() const {
+    uint64_t n = 0;
+    for(const auto& r : readers_) n += r->records();
+    return n;
+}
+
+uint64_t MergedEventReader::parse_errors() const {
+    uint64_t n = 0;
+    for(const auto& r : readers_) n += r->parse_errors();
+    return n;
+}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../common/event.hpp"
+#include "event_reader.hpp"
+
+namespace md {
+
+/*
+ * MergedEventReader
+ * -----------------
+ * Streams several recordings (any mix of formats, journal directories
+ * included) as one, ordered by ts_ns with ties broken by seq and then by
+ * input position:
+ *
+ *   md::MergedEventReader r({"logs/day1_fx.bin", "logs/day1_idx.bin"});
+ *   md::Event e;
+ *   while (r.next(e)) { ... }
+ *
+ * A k-way merge over a binary heap holding one decoded event per input, so
+ * next() is O(log k). Each input must already be in time order (as the
+ * recorder writes it); an input that steps backwards is passed through in
+ * its own order rather than re-sorted.
+ *
+ * Memory per input is one event plus its reader's window: the mappings are
+ * read ahead and released behind the cursor at readahead_bytes (see
+ * EventReaderConfig), so resident memory stays flat however many files
+ * are merged.
+ */
+class MergedEventReader {
+public :
+    // Default per-input reader settings: a smaller window than a single
+    // reader uses, since there is one per file.
+    static EventReaderConfig default_input_config() {
+        EventReaderConfig cfg;
+        cfg.readahead_bytes = 4u << 20;
+        return cfg;
+    }
+
+    // pre, if active, is applied inside each input's reader (see
+    // EventFileReader::set_prefilter).
+    explicit MergedEventReader(const std::vector<std::string>& paths,
+                               const EventReaderConfig& input_cfg = default_input_config(),
+                               const EventPrefilter& pre = {});
+
+    // False if any input failed to open.
+    bool ok() const { return ok_; }
+    std::size_t inputs() const { return readers_.size(); }
+
+    // Next event across all inputs; false once every input is exhausted.
+    bool next(Event& out);
+
+    // Seeks every input (EventFileReader::seek_to_ts / seek_to_seq) and
+    // restarts the merge there. False if no input has such an event.
+    bool seek_to_ts(uint64_t ts_ns);
+    bool seek_to_seq(uint64_t seq);
+
+    // Input index (position in paths) of the event next() returned last.
+    std::size_t source() const { return source_; }
+
+    uint64_t records() const;
+    uint64_t parse_errors() const;
+
+private :
+    struct Head {
+        uint64_t ts_ns;
+        uint64_t seq;
+        std::size_t input;
+
+        bool operator>(const Head& o) const {
+            if(ts_ns != o.ts_ns) return ts_ns > o.ts_ns;
+            if(seq != o.seq) return seq > o.seq;
+            return input > o.input;
+        }
+    };
+
+    bool ok_{false};
+    std::vector<std::unique_ptr<EventFileReader>> readers_;
+    std::vector<Event> heads_;   // next undelivered event of each input
+    std::vector<Head> heap_;     // min-heap (std::greater) over inputs that have one
+    std::size_t source_{0};
+
+    void push(std::size_t input);
+    bool seek_to_key(uint64_t target, bool by_seq);
+};
+
+}
@@ -1,7 +1,18 @@
 #include "replay.hpp"
-
+#include "event_reader.hpp"
+#include "merged_reader.hpp"
+#include "dataset_cache.hpp"
+#include "batch_reader.hpp"
+#include "../common/bounded_queue.hpp"
+#include "../common/event_index.hpp"
+#include "../common/latency_histogram.hpp"
+
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <chrono>
+#include <optional>
+#include <random>
 #include <thread>
 #include <iostream>
 #include <string>
@@ -9,67 +20,240 @@
 namespace md {
 
 EventReplay::EventReplay(const std::string& path)
-    :path_(path) {}
+    :paths_{path}, name_(path) {}
 
-bool EventReplay::match_filter(const Event& e) const {
-    if(filter_.filter_by_topic && e.h.topic != filter_.topic) {
-        return false;
+EventReplay::EventReplay(std::vector<std::string> paths)
+    :paths_(std::move(paths)) {
+    name_ = paths_.size() == 1 ? paths_[0] : fmt::format("{} merged files", paths_.size());
+}
+
+bool event_matches(const ReplayFilter& f, const Event& e) {
+    if(f.filter_by_topic) {
+        const uint64_t mask = f.topics ? f.topics : EventPrefilter::topic_bit(f.topic);
+        if((mask & EventPrefilter::topic_bit(e.h.topic)) == 0) {
+            return false;
+        }
     }
 
-    if(filter_.filter_by_symbol) {
+    if(f.filter_by_symbol) {
         if(!std::holds_alternative<Tick>(e.p)) {
             return false;
         }
         const auto& t = std::get<Tick> (e.p);
-        if(t.symbol != filter_.symbol) {
+        if(f.symbols.empty() ? t.symbol != f.symbol
+                             : std::find(f.symbols.begin(), f.symbols.end(), t.symbol) == f.symbols.end()) {
             return false;
         }
     }
 
-    if(filter_.filter_by_time) {
-        if(e.h.ts_ns < filter_.ts_min || e.h.ts_ns > filter_.ts_max) {
+    if(f.filter_by_time) {
+        if(e.h.ts_ns < f.ts_min || e.h.ts_ns > f.ts_max) {
             return false;
         }
     }
     return true;
 }
 
+EventPrefilter prefilter_for(const ReplayFilter& f) {
+    EventPrefilter pre;
+    if(f.filter_by_topic) {
+        pre.set_topics(f.topics ? f.topics : EventPrefilter::topic_bit(f.topic));
+    }
+    if(f.filter_by_symbol) {
+        if(f.symbols.empty()) pre.add_symbol(f.symbol);
+        for(const auto& s : f.symbols) pre.add_symbol(s);
+    }
+    if(f.filter_by_time) {
+        pre.set_time_range(f.ts_min, f.ts_max);
+    }
+    return pre;
+}
 
-template <typename Fn>
-static void for_each_event_in_file(const std::string& path, Fn&& fn){
-    std::ifstream in(path);
-    if(!in){
-        log_error("EventReplay: failed to open replay file '{}'", path);
+void EventReplay::seek_to_seq(uint64_t seq) {
+    start_ = ReplayStart{ReplayStart::From::Seq, seq, 0};
+}
+
+void EventReplay::seek_to_ts(uint64_t ts_ns) {
+    start_ = ReplayStart{ReplayStart::From::Ts, 0, ts_ns};
+}
+
+void EventReplay::resume_from(const ReplayCheckpoint& cp) {
+    if(!cp.valid) {
+        rewind();
         return;
     }
+    start_ = ReplayStart{ReplayStart::From::After, cp.seq, cp.ts_ns};
+}
+
+void EventReplay::begin_run() {
+    events_published_ = 0;
+    pause_.store(false);
+    paused_ = false;
+    checkpoint_ = start_.from == ReplayStart::From::After
+        ? ReplayCheckpoint{true, start_.seq, start_.ts_ns}
+        : ReplayCheckpoint{};
+}
+
+bool EventReplay::admit(const Event& e) {
+    if(pause_.exchange(false)) {
+        paused_ = true;
+        log_info("EventReplay: paused after seq={} ts={}", checkpoint_.seq, checkpoint_.ts_ns);
+        return false;
+    }
+    checkpoint_ = ReplayCheckpoint{true, e.h.seq, e.h.ts_ns};
+    return true;
+}
+
+uint64_t EventReplay::scan(const std::function<bool(Event&)>& fn) {
+    if(use_cache_ && paths_.size() == 1) {
+        ColumnDataset d;
+        if(d.open(paths_[0], cache_dir_)) {
+            log_info("EventReplay: replaying '{}' from its dataset cache '{}'", name_, d.cache_path());
+            return scan_dataset(d, filter_, fn, start_);
+        }
+    }
+    return scan_events(paths_, filter_, fn, start_);
+}
+
+bool EventReplay::match_filter(const Event& e) const {
+    return event_matches(filter_, e);
+}
 
-    std::string line;
-    while(std::getline(in, line)) {
-        if(line.empty())continue;
-        Event e;
-        if(!parse_event(line, e)) {
-            log_warn("EventReplay: failed to parse line: {}", line);
-            continue;
+// Index blocks that can contain events matching f, ascending.
+static std::vector<std::size_t> candidate_blocks(const EventIndex& idx, const ReplayFilter& f) {
+    std::vector<std::size_t> out;
+    auto overlaps = [&](std::size_t i) {
+        const auto& b = idx.blocks()[i];
+        return !f.filter_by_time || (b.ts_max >= f.ts_min && b.ts_min <= f.ts_max);
+    };
+    if(f.filter_by_symbol) {
+        auto add = [&](const std::string& sym) {
+            if(const auto* ids = idx.blocks_for_symbol(sym)) {
+                for(uint32_t i : *ids) {
+                    if(overlaps(i)) out.push_back(i);
+                }
+            }
+        };
+        if(f.symbols.empty()) add(f.symbol);
+        for(const auto& sym : f.symbols) add(sym);
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    } else {
+        for(std::size_t i = 0; i < idx.blocks().size(); ++i) {
+            if(overlaps(i)) out.push_back(i);
         }
+    }
+    return out;
+}
+
+// True for events a scan from start skips, once positioned.
+static bool before_start(const ReplayStart& start, const Event& e) {
+    return start.from == ReplayStart::From::After &&
+           (e.h.ts_ns < start.ts_ns || (e.h.ts_ns == start.ts_ns && e.h.seq <= start.seq));
+}
+
+uint64_t scan_events(const std::string& path, const ReplayFilter& f,
+                     const std::function<bool(Event&)>& fn, const ReplayStart& start) {
+    EventFileReader reader(path);
+    if(!reader.ok()){
+        log_error("EventReplay: failed to open replay file '{}'", path);
+        return 0;
+    }
+
+    // Rejects are dropped inside the reader before their payload is
+    // decoded; admits() re-checks what the reader could not (journals).
+    const EventPrefilter pre = prefilter_for(f);
+    reader.set_prefilter(pre);
+
+    uint64_t matched = 0;
+    bool stop = false;
+    Event e;
+    auto visit = [&]() {
         if(e.h.ts_ns == 0) {
-            log_info("EventReplay: skipping internal event");
-            continue;
+            log_info("EventReplay: skipping internal event (seq={}, topic={})",
+                     e.h.seq,
+                     static_cast<int>(e.h.topic));
+            return;
         }
-        if(!fn(e)){
-            break;
+        if(!pre.admits(e)) return;
+        ++matched;
+        if(!fn(e)) stop = true;
+    };
+
+    if(start.from != ReplayStart::From::Beginning) {
+        const bool found = start.from == ReplayStart::From::Seq ? reader.seek_to_seq(start.seq)
+                                                                : reader.seek_to_ts(start.ts_ns);
+        while(found && !stop && reader.next(e)) {
+            if(!before_start(start, e)) visit();
         }
+        return matched;
     }
-}
 
-void EventReplay::replay_fast(EventBus& bus){
-    log_info("EventReplay: starting fast replay from '{}'", path_);
-    events_published_ = 0;
+    EventIndex idx;
+    const bool use_index = (f.filter_by_time || f.filter_by_symbol) && !reader.is_journal() &&
+                           idx.load_for(path) && idx.format() == reader.format();
+    if(!use_index) {
+        while(!stop && reader.next(e)) visit();
+        return matched;
+    }
 
-    for_each_event_in_file(path_, [this, &bus](Event& e) {
-        if(!match_filter(e)) {
-            return true; // want the function to coninue;
+    if(reader.format() != RecordFormat::Text) reader.set_symbols(idx.symbols());
+
+    // The last block may have grown after the index was written (and in a
+    // binary log its deltas continue past data_bytes), so it is never
+    // skipped: it is read in full together with whatever follows it.
+    const auto& all = idx.blocks();
+    const std::size_t last = all.empty() ? 0 : all.size() - 1;
+    const uint64_t tail_off = all.empty() ? reader.offset() : all[last].offset;
+
+    const auto blocks = candidate_blocks(idx, f);
+    MD_LOG_DEBUG("EventReplay: index selects {} of {} blocks in '{}'",
+                 blocks.size(), all.size(), path);
+
+    for(std::size_t i : blocks) {
+        if(stop || i == last) break;
+        const uint64_t end = idx.block_end(i);
+        if(reader.offset() != all[i].offset && !reader.seek(all[i].offset)) break;
+        while(!stop && reader.offset() < end && reader.next(e)) {
+            if(reader.record_offset() >= end) break; // ran into the next block
+            visit();
         }
+    }
+
+    if(!stop && (reader.offset() == tail_off || reader.seek(tail_off))) {
+        while(!stop && reader.next(e)) visit();
+    }
+    return matched;
+}
+
+uint64_t scan_events(const std::vector<std::string>& paths, const ReplayFilter& f,
+                     const std::function<bool(Event&)>& fn, const ReplayStart& start) {
+    if(paths.size() == 1) return scan_events(paths[0], f, fn, start);
+
+    const EventPrefilter pre = prefilter_for(f);
+    MergedEventReader reader(paths, MergedEventReader::default_input_config(), pre);
+    if(!reader.ok()) {
+        log_error("EventReplay: failed to open the {} replay files", paths.size());
+        return 0;
+    }
+    if(start.from == ReplayStart::From::Seq) reader.seek_to_seq(start.seq);
+    else if(start.from != ReplayStart::From::Beginning) reader.seek_to_ts(start.ts_ns);
+
+    uint64_t matched = 0;
+    Event e;
+    while(reader.next(e)) {
+        if(e.h.ts_ns == 0 || before_start(start, e) || !pre.admits(e)) continue;
+        ++matched;
+        if(!fn(e)) break;
+    }
+    return matched;
+}
+
+void EventReplay::replay_fast(EventBus& bus){
+    log_info("EventReplay: starting fast replay from '{}'", name_);
+    begin_run();
 
+    scan([this, &bus](Event& e) {
         if (filter_.limit_events && 
             events_published_ >= filter_.max_events) {
             log_info("EventReplay: reached max_events = {} in fast replay", filter_.max_events);
@@ -82,6 +266,7 @@ void EventReplay::replay_fast(EventBus& bus){
             std::getline(std::cin, dummy);
         }
 
+        if(!admit(e)) return false;
         bus.publish_preserve(e);
         ++events_published_;
         return true;
@@ -90,10 +275,72 @@ void EventReplay::replay_fast(EventBus& bus){
     log_info("EventReplay: fast replay finished");
 }
 
+void EventReplay::replay_parallel(EventBus& bus, unsigned threads) {
+    if(paths_.size() != 1 || start_.from != ReplayStart::From::Beginning || use_cache_) {
+        replay_fast(bus);
+        return;
+    }
+    const std::string& path = paths_[0];
+    BatchReaderConfig cfg;
+    cfg.threads = threads;
+    const EventPrefilter pre = prefilter_for(filter_);
+    EventBatchReader reader(path, cfg, [pre](const Event& e) {
+        return e.h.ts_ns != 0 && pre.admits(e);
+    }, pre);
+    if(!reader.ok()) {
+        log_error("EventReplay: failed to open replay file '{}'", path);
+        return;
+    }
+    log_info("EventReplay: starting parallel replay from '{}' ({})",
+             path, to_string(reader.format()));
+    begin_run();
+
+    std::vector<Event> batch;
+    bool stop = false;
+    while(!stop && reader.next_batch(batch)) {
+        for(auto& e : batch) {
+            if(filter_.limit_events && events_published_ >= filter_.max_events) {
+                log_info("EventReplay: reached max_events = {} in parallel replay", filter_.max_events);
+                stop = true;
+                break;
+            }
+            if(step_mode_) {
+                fmt::print("[STEP] Press Enter to play next event...\n");
+                std::string dummy;
+                std::getline(std::cin, dummy);
+            }
+            if(!admit(e)) {
+                stop = true;
+                break;
+            }
+            bus.publish_preserve(std::move(e));
+            ++events_published_;
+        }
+    }
+    log_info("EventReplay: parallel replay finished ({} events, {} unreadable records)",
+             events_published_, reader.parse_errors());
+}
+
 void EventReplay::replay_realtime(EventBus& bus){
     replay_speed(bus, 1.0);
 }
 
+// Waits until deadline: sleeps to within kSpinWindow of it (sleep_until
+// overshoots by tens of microseconds), then spins on the clock.
+static constexpr auto kSpinWindow = std::chrono::microseconds(200);
+
+static void wait_until(std::chrono::steady_clock::time_point deadline) {
+    using clock = std::chrono::steady_clock;
+    if(deadline - clock::now() > kSpinWindow) {
+        std::this_thread::sleep_until(deadline - kSpinWindow);
+    }
+    while(clock::now() < deadline) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+}
+
 void EventReplay::replay_speed(EventBus& bus, double speed){
     if(speed <= 0.0){
         log_warn("EventReplay: invalid speed {} using 1.0", speed);
@@ -101,85 +348,124 @@ void EventReplay::replay_speed(EventBus& bus, double speed){
     }
 
     log_info("EventReplay: starting timed replay from '{}' with speed {}x",
-        path_, speed);
+        name_, speed);
 
-    std::ifstream in(path_);
-    if(!in) {
-        log_error("EventReplay: failed to open replay file '{}'", path_);
-        return ;
-    }
-    std::string line;
-    bool first = true;
-    events_published_  = 0;
+    // Each event is due at anchor + (ts - first_ts) / speed, so sleep
+    // overshoot and publish time never accumulate. Timestamps that step
+    // backwards are due immediately.
     uint64_t first_ts = 0;
-    uint64_t prev_ts = 0;
-    auto wall_start = std::chrono::steady_clock::now();
+    uint64_t sched_ts = 0;
+    replay_paced(bus, "timed", [&](Event& e, uint64_t n) {
+        if(n == 0) first_ts = sched_ts = e.h.ts_ns;
+        sched_ts = std::max(sched_ts, e.h.ts_ns);
+        return std::chrono::nanoseconds(
+            static_cast<int64_t>(static_cast<double>(sched_ts - first_ts) / speed));
+    });
+}
 
-    while (std::getline(in , line)) {
-        if(line.empty())continue;
-        Event e;
-        if(!parse_event(line, e)) {
-            log_warn("EventReplay: failed to parse line: {}", line);
-            continue;
-        }
+void EventReplay::replay_rate(EventBus& bus, const ReplayRateConfig& cfg) {
+    double rate = cfg.events_per_sec;
+    if(rate <= 0.0) {
+        log_warn("EventReplay: invalid rate {} using 1000/s", rate);
+        rate = 1000.0;
+    }
+    const uint64_t burst = std::max<std::size_t>(cfg.burst_events, 1);
+    const double interval_ns = cfg.burst_interval_ns
+        ? static_cast<double>(cfg.burst_interval_ns)
+        : static_cast<double>(burst) * 1e9 / rate;
+
+    if(burst > 1) {
+        log_info("EventReplay: starting burst replay from '{}': {} events every {} us",
+                 name_, burst, interval_ns / 1e3);
+    } else {
+        log_info("EventReplay: starting rate replay from '{}' at {} events/s", name_, rate);
+    }
 
-        if(e.h.ts_ns == 0) {
-            log_info("Replay: skipping internal stop event (seq={}, topic={})",
-                     e.h.seq,
-                     static_cast<int>(e.h.topic));
-            continue;
+    // Event n is due with its burst, n / burst intervals after the anchor
+    // (one event per burst when not bursting).
+    std::mt19937_64 rng(cfg.seed);
+    const auto jitter = static_cast<int64_t>(std::min<uint64_t>(cfg.jitter_ns, INT64_MAX / 2));
+    std::uniform_int_distribution<int64_t> offset(-jitter, jitter);
+    replay_paced(bus, burst > 1 ? "burst" : "rate", [&](Event& e, uint64_t n) {
+        if(jitter > 0) {
+            const int64_t ts = static_cast<int64_t>(e.h.ts_ns) + offset(rng);
+            e.h.ts_ns = ts > 0 ? static_cast<uint64_t>(ts) : 1;
         }
+        return std::chrono::nanoseconds(
+            static_cast<int64_t>(static_cast<double>(n / burst) * interval_ns));
+    });
+}
 
-        if(!match_filter(e)) {
-            continue;
-        }
+void EventReplay::replay_paced(EventBus& bus, const char* what, const Pacer& due) {
+    using clock = std::chrono::steady_clock;
+    static constexpr std::size_t kParseAhead = 4096;
+
+    begin_run();
+    pacing_ = ReplayPacingStats{};
+
+    // Events are read, parsed and filtered on a separate thread so the
+    // pacing loop only waits and publishes. An empty optional marks the end.
+    BoundedQueue<std::optional<Event>> ahead(kParseAhead);
+    std::atomic<bool> cancel{false};
+    std::thread parser([&] {
+        scan([&](Event& e) {
+            ahead.push(std::move(e));
+            return !cancel.load(std::memory_order_relaxed);
+        });
+        ahead.push(std::nullopt);
+    });
 
+    LatencyHistogram lag;
+    clock::time_point anchor;
+    uint64_t n = 0;
+    std::optional<Event> item;
+    for(;;) {
+        ahead.pop(item);
+        if(!item) break;
+        Event& e = *item;
         if(filter_.limit_events &&
             events_published_ >= filter_.max_events) {
-            log_info("EventReplay: reached max_events={} in timed replay",
-                     filter_.max_events);
+            log_info("EventReplay: reached max_events={} in {} replay",
+                     filter_.max_events, what);
+            cancel = true;
+            while(item) ahead.pop(item); // let the parser finish
             break;
         }
 
-        if(first) {
-            first = false;
-            first_ts = e.h.ts_ns;
-            prev_ts = e.h.ts_ns;
-            wall_start = std::chrono::steady_clock::now();
-
-            if (step_mode_) {
-                fmt::print("[STEP] Press Enter to play next event...\n");
-                std::string dummy;
-                std::getline(std::cin, dummy);
-            }
-
-            bus.publish_preserve(e);
-            ++events_published_;
-            continue;
-        }
-
-        int64_t dt_ns = static_cast<int64_t>(e.h.ts_ns) -                   
-                            static_cast<int64_t>(prev_ts);
-        if (dt_ns < 0) dt_ns = 0;  // don't go backwards
-        //i.e treat them as zero delay
-
-        double scaled_ns = dt_ns / speed;
-        auto dur = std::chrono::nanoseconds(static_cast<int64_t>(scaled_ns));
-
-        if (dur.count() > 0) {
-            std::this_thread::sleep_for(dur);
-        }
-
-          if (step_mode_) {
+        if (step_mode_) {
             fmt::print("[STEP] Press Enter to play next event...\n");
             std::string dummy;
             std::getline(std::cin, dummy);
         }
 
-        bus.publish_preserve(e);
+        if(events_published_ == 0 || step_mode_) {
+            // (re)anchor the schedule: first event, or after a manual step
+            anchor = clock::now();
+            n = 0;
+        }
+        // admitted first, so a checkpoint holds the recorded header
+        if(!admit(e)) {
+            cancel = true;
+            while(item) ahead.pop(item);
+            break;
+        }
+        const auto deadline = anchor + due(e, n++);
+        wait_until(deadline);
+        lag.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - deadline).count()));
+
+        bus.publish_preserve(std::move(e));
         ++events_published_;
     }
-    log_info("EventReplay: timed replay finished");
+    parser.join();
+
+    pacing_.events = lag.count();
+    pacing_.max_lag_ns = lag.max();
+    pacing_.p99_lag_ns = lag.percentile(0.99);
+    pacing_.mean_lag_ns = lag.mean();
+    log_info("EventReplay: {} replay finished: {} events, lag behind schedule "
+             "mean={} ns p99={} ns max={} ns",
+             what, pacing_.events, pacing_.mean_lag_ns, pacing_.p99_lag_ns, pacing_.max_lag_ns);
 }
 
 }
\ No newline at end of file
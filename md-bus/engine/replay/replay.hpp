@@ -1,7 +1,12 @@
 #pragma once 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "../common/event.hpp"
+#include "../common/event_filter.hpp"
 #include "../common/event_io.hpp"
 #include "../common/log.hpp"
 #include "../bus/bus.hpp"
@@ -12,9 +17,14 @@ namespace md {
 struct ReplayFilter {
     bool filter_by_topic{false};
     Topic topic{};
+    // Several topics: EventPrefilter::topic_bit per topic. When non-zero it
+    // replaces `topic`.
+    uint64_t topics{0};
 
     bool filter_by_symbol{false};
     std::string symbol;
+    // Several symbols; when non-empty it replaces `symbol`.
+    std::vector<std::string> symbols;
 
     bool filter_by_time{false};
     uint64_t ts_min{0};
@@ -22,29 +32,149 @@ struct ReplayFilter {
 
     bool limit_events{0};
     size_t max_events{0};
+
+    void add_topic(Topic t) {
+        filter_by_topic = true;
+        topics |= EventPrefilter::topic_bit(t);
+    }
+    void add_symbol(std::string s) {
+        filter_by_symbol = true;
+        symbols.push_back(std::move(s));
+    }
+};
+
+// True if e passes f's topic / symbol / time filters (max_events aside).
+bool event_matches(const ReplayFilter& f, const Event& e);
+
+// f's topic / symbol / time filters as a prefilter for the readers.
+EventPrefilter prefilter_for(const ReplayFilter& f);
+
+// Where a scan starts: the first event with seq / ts_ns at or above the
+// given one, or (After) the first event past (ts_ns, seq) in (ts, seq)
+// order, which is how a checkpoint resumes.
+struct ReplayStart {
+    enum class From : uint8_t { Beginning, Seq, Ts, After };
+    From from{From::Beginning};
+    uint64_t seq{0};
+    uint64_t ts_ns{0};
+};
+
+// The last event a replay published; resume_from() continues after it.
+struct ReplayCheckpoint {
+    bool valid{false};
+    uint64_t seq{0};
+    uint64_t ts_ns{0};
+};
+
+// Calls fn for every event in path that matches f, in file order (from
+// start, see EventFileReader::seek_to_ts), until fn returns false. With a
+// <path>.idx sidecar, a time or symbol filter only reads the index blocks
+// that can hold matches; within them, records that fail the filter are
+// dropped before their payload is decoded. Returns the events matched.
+uint64_t scan_events(const std::string& path, const ReplayFilter& f,
+                     const std::function<bool(Event&)>& fn,
+                     const ReplayStart& start = {});
+
+// Same over several logs merged by (ts_ns, seq), see MergedEventReader.
+// One path is the single-file scan above; with more, indexes are not used
+// for filtering (a start position still seeks each input).
+uint64_t scan_events(const std::vector<std::string>& paths, const ReplayFilter& f,
+                     const std::function<bool(Event&)>& fn,
+                     const ReplayStart& start = {});
+
+// How closely the last timed replay kept to its schedule: lag is the time
+// between an event's due time and its publish.
+struct ReplayPacingStats {
+    uint64_t events{0};
+    uint64_t mean_lag_ns{0};
+    uint64_t p99_lag_ns{0};
+    uint64_t max_lag_ns{0};
+};
+
+// Load-test pacing for replay_rate: recorded content, synthetic timing.
+struct ReplayRateConfig {
+    // Target publish rate; recorded timestamps are ignored for pacing.
+    double events_per_sec{100'000.0};
+
+    // Burst mode (burst_events > 1): burst_events are published back to
+    // back, then the replay waits for the next burst, burst_interval_ns
+    // after the previous one (0 = burst_events / events_per_sec, so the
+    // average rate stays events_per_sec).
+    std::size_t burst_events{0};
+    uint64_t burst_interval_ns{0};
+
+    // Adds a uniform offset in [-jitter_ns, +jitter_ns] to each published
+    // event's ts_ns (clamped at 1), reproducible for a given seed.
+    uint64_t jitter_ns{0};
+    uint64_t seed{1};
 };
 
 class EventReplay {
 private : 
-    std::string path_;
+    std::vector<std::string> paths_;
+    std::string name_;  // for log messages
     ReplayFilter filter_{};
     bool step_mode_{false};
     size_t events_published_{0};
+    ReplayPacingStats pacing_{};
+    ReplayStart start_{};
+    std::atomic<bool> pause_{false};
+    bool paused_{false};
+    ReplayCheckpoint checkpoint_{};
+    bool use_cache_{false};
+    std::string cache_dir_;
+
+    // Publishes the replay from a parse-ahead thread, each event at
+    // anchor + due(e, n), n counting events since the schedule was
+    // anchored (at the first event and after each manual step). due may
+    // also adjust e before it is published.
+    using Pacer = std::function<std::chrono::nanoseconds(Event& e, uint64_t n)>;
+    void replay_paced(EventBus& bus, const char* what, const Pacer& due);
+
+    // scan_events over paths_ from start_, through the dataset cache if on.
+    uint64_t scan(const std::function<bool(Event&)>& fn);
+
+    // Resets the per-run state: the count, a pause requested after the
+    // last run ended, and the checkpoint (to the resume point, if any).
+    void begin_run();
+
+    // Called before publishing e: false once a pause was requested.
+    bool admit(const Event& e);
     
     //Returns true if event passes all active filters
     bool match_filter(const Event& e) const;
 public : 
+    // path: a recorded log (text or binary) or a journal directory
     explicit EventReplay(const std::string& path);
 
+    // Several logs (e.g. one per day or symbol group) replayed as one
+    // stream, merged by ts_ns with ties broken by seq.
+    explicit EventReplay(std::vector<std::string> paths);
+
     // Fast : no sleeps, just shove everything into the bus
     void replay_fast(EventBus& bus);
 
-    //Real-time based on recorded ts_ns deltas (best effort)
+    // Real-time based on recorded ts_ns (see replay_speed)
     void replay_realtime(EventBus& bus);
 
-    // Same as realtime but scaled (speed > 1 then faster else slower)
+    // Same as realtime but scaled (speed > 1 then faster else slower).
+    // Events are paced against absolute deadlines from the first event,
+    // with a sleep-then-spin wait; parsing runs ahead on its own thread.
     void replay_speed(EventBus & bus, double speed);
 
+    // Load testing: publishes at a fixed rate, or in bursts, regardless of
+    // the recorded timestamps, with optional ts jitter (ReplayRateConfig).
+    // Paced like replay_speed; the lag in pacing_stats() shows whether the
+    // bus kept up with the target rate.
+    void replay_rate(EventBus& bus, const ReplayRateConfig& cfg);
+
+    // Fast, pipelined: a reader thread cuts the log into newline-aligned
+    // chunks, `threads` parser threads (0 = all cores) decode and filter
+    // them, and this thread publishes the survivors in file order. Binary
+    // logs are decoded on the reader thread. Does not use the .idx sidecar.
+    // A multi-file replay is merged sequentially, as replay_fast.
+    void replay_parallel(EventBus& bus, unsigned threads = 0);
+
     inline void set_filter(const ReplayFilter& f) {filter_ = f;}
     void clear_filter() {filter_ = ReplayFilter{};}
 
@@ -54,6 +184,39 @@ public :
     }
 
     void enable_step_mode(bool on = true) {step_mode_ = on ;} 
+
+    // Replays a single-file log from its columnar dataset cache in dir (""
+    // = next to the log), built on first use (see ColumnDataset): later
+    // replays of the same, unchanged log skip parsing altogether.
+    // replay_parallel then runs as replay_fast. Multi-file replays and
+    // journal directories are read as usual.
+    void use_dataset_cache(std::string dir = "") {
+        use_cache_ = true;
+        cache_dir_ = std::move(dir);
+    }
+
+    // Where the next replay_* call starts (until changed): the first event
+    // with seq / ts_ns at or above n, found by binary search (see
+    // EventFileReader::seek_to_ts). replay_parallel falls back to
+    // replay_fast when a start is set.
+    void seek_to_seq(uint64_t seq);
+    void seek_to_ts(uint64_t ts_ns);
+    void rewind() { start_ = ReplayStart{}; }
+
+    // Stops a running replay before its next event; safe to call from any
+    // thread, including a subscriber. A request made while no replay runs
+    // is dropped when the next one starts. paused() then tells a pause from a
+    // replay that ran to the end, and checkpoint() where it stopped.
+    void pause() { pause_ = true; }
+    bool paused() const { return paused_; }
+    const ReplayCheckpoint& checkpoint() const { return checkpoint_; }
+
+    // The next replay_* call continues after cp (from this or an earlier
+    // replay of the same logs).
+    void resume_from(const ReplayCheckpoint& cp);
+
+    // Schedule lag of the last replay_realtime / replay_speed / replay_rate run.
+    const ReplayPacingStats& pacing_stats() const { return pacing_; }
 };
 
 }
\ No newline at end of file
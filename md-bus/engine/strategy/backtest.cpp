@@ -0,0 +1,141 @@
+#include "backtest.hpp"
+
+#include "../common/log.hpp"
+#include "../replay/dataset_cache.hpp"
+#include "dispatch.hpp"
+
+namespace md {
+
+BacktestDriver::BacktestDriver(const std::string& path, const BacktestConfig& cfg)
+    : BacktestDriver(std::vector<std::string>{path}, cfg) {}
+
+BacktestDriver::BacktestDriver(std::vector<std::string> paths, const BacktestConfig& cfg)
+    : paths_(std::move(paths))
+    , cfg_(cfg)
+    , bars_(cfg.timeframes) {
+    if(!cfg_.build_bars || cfg_.filter.filter_by_topic) return;
+    for(const auto& tf : bars_.timeframes()) rebuilt_topics_ |= EventPrefilter::topic_bit(tf.topic);
+    // every other topic, so the readers skip recorded bars undecoded
+    cfg_.filter.filter_by_topic = true;
+    cfg_.filter.topics = ~rebuilt_topics_;
+}
+
+void BacktestDriver::add_strategy(IStrategy* strat) {
+    if(!strat) return;
+    strategies_.push_back(strat);
+    log_info("BacktestDriver: added strategy '{}'", strat->name());
+}
+
+void BacktestDriver::deliver(const Event& e) {
+    if(sink_) sink_->push_back(e);
+    else dispatch_event(e, strategies_);
+}
+
+void BacktestDriver::dispatch_bar(const Bar& b, Topic topic) {
+    ++stats_.bars;
+    deliver(BarAggregator::bar_event(b, topic));
+}
+
+void BacktestDriver::feed(const Event& e) {
+    if(rebuilt_topics_ & EventPrefilter::topic_bit(e.h.topic)) return;
+    ++stats_.events;
+    deliver(e);
+    if(e.h.topic != Topic::MD_TICK) return;
+
+    const auto* t = std::get_if<Tick>(&e.p);
+    if(!t) return;
+    ++stats_.ticks;
+    if(cfg_.build_bars) {
+        bars_.on_tick(*t, e.h.ts_ns, [this](const Bar& b, Topic topic) { dispatch_bar(b, topic); });
+    }
+}
+
+void BacktestDriver::finish() {
+    if(cfg_.build_bars) bars_.flush([this](const Bar& b, Topic topic) { dispatch_bar(b, topic); });
+    if(sink_) return;
+    for(auto* strat : strategies_) {
+        log_info("BacktestDriver: finalizing strategy '{}'", strat->name());
+        strat->finalize();
+    }
+}
+
+void BacktestDriver::read_logs() {
+    const ReplayFilter& f = cfg_.filter;
+    scan_events(paths_, f, [&](Event& e) {
+        if(f.limit_events && stats_.events >= f.max_events) return false;
+        feed(e);
+        return true;
+    }, cfg_.start);
+}
+
+// As read_logs, from the columns: rows are filtered without decoding and
+// bars are built from the price / qty / symbol id columns.
+bool BacktestDriver::read_cached() {
+    if(paths_.size() != 1) return false;
+    ColumnDataset d;
+    if(!d.open(paths_[0], cfg_.cache_dir)) return false;
+    log_info("BacktestDriver: reading '{}' from its dataset cache '{}'", paths_[0], d.cache_path());
+
+    const ReplayFilter& f = cfg_.filter;
+    const auto tick = static_cast<uint8_t>(PayloadKind::Tick);
+    const auto md_tick = static_cast<uint8_t>(Topic::MD_TICK);
+    Event e;
+    auto on_bar = [this](const Bar& b, Topic topic) { dispatch_bar(b, topic); };
+    for_each_row(d, f, cfg_.start, [&](std::size_t i) {
+        if(f.limit_events && stats_.events >= f.max_events) return false;
+        d.event_at(i, e);
+        ++stats_.events;
+        deliver(e);
+        if(d.topic()[i] == md_tick && d.kind()[i] == tick) {
+            ++stats_.ticks;
+            const uint32_t sym = d.symbol()[i];
+            if(cfg_.build_bars) {
+                bars_.on_tick_id(sym, d.symbols()[sym], d.price()[i], d.qty()[i], d.ts()[i], on_bar);
+            }
+        }
+        return true;
+    });
+    return true;
+}
+
+BacktestStats BacktestDriver::run() {
+    bars_ = BarAggregator(cfg_.timeframes);
+    stats_ = BacktestStats{};
+    const uint64_t t0 = now_ns();
+
+    if(!cfg_.use_cache || !read_cached()) read_logs();
+    finish();
+
+    stats_.elapsed_ns = now_ns() - t0;
+    log_info("BacktestDriver: {} events ({} ticks, {} bars) in {} ms",
+             stats_.events, stats_.ticks, stats_.bars, stats_.elapsed_ns / 1'000'000);
+    return stats_;
+}
+
+BacktestStats BacktestDriver::collect(std::vector<Event>& out) {
+    sink_ = &out;
+    run();
+    sink_ = nullptr;
+    return stats_;
+}
+
+BacktestStats BacktestDriver::run(const EventDataset& data) {
+    stats_ = data.stats();
+    const uint64_t t0 = now_ns();
+    for(const Event& e : data.events()) dispatch_event(e, strategies_);
+    for(auto* strat : strategies_) strat->finalize();
+    stats_.elapsed_ns = now_ns() - t0;
+    return stats_;
+}
+
+bool EventDataset::load(const std::vector<std::string>& paths, const BacktestConfig& cfg) {
+    events_.clear();
+    BacktestDriver drv(paths, cfg);
+    stats_ = drv.collect(events_);
+    events_.shrink_to_fit();
+    log_info("EventDataset: loaded {} events ({} bars) in {} ms",
+             events_.size(), stats_.bars, stats_.elapsed_ns / 1'000'000);
+    return !events_.empty();
+}
+
+}
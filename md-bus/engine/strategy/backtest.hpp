@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../bar/bar_aggregator.hpp"
+#include "../common/event.hpp"
+#include "../replay/replay.hpp"
+#include "strategy.hpp"
+
+namespace md {
+
+struct BacktestConfig {
+    // Which recorded events are fed, and from where (as for EventReplay).
+    // With build_bars and no topic filter, recorded events on the topics of
+    // `timeframes` are left out: the rebuilt bars take their place rather
+    // than arriving next to them.
+    ReplayFilter filter{};
+    ReplayStart start{};
+
+    // Aggregate MD_TICK into bars, as a BarBuilder on the bus would: the
+    // first timeframe from ticks, the rest rolled up (see BarAggregator).
+    bool build_bars{true};
+    std::vector<BarTimeframe> timeframes{{BarAggregator::NS_PER_SEC, Topic::BAR_1S}};
+
+    // Read a single-file log through its dataset cache in cache_dir (see
+    // ColumnDataset, EventReplay::use_dataset_cache): filters and bars then
+    // work on the cached columns and nothing is parsed after the first run.
+    bool use_cache{false};
+    std::string cache_dir;
+};
+
+class EventDataset;
+
+struct BacktestStats {
+    uint64_t events{0};     // recorded events dispatched
+    uint64_t ticks{0};
+    uint64_t bars{0};       // bars built (including the final flush)
+    uint64_t elapsed_ns{0}; // wall time of run()
+};
+
+/*
+ * BacktestDriver
+ * --------------
+ * Runs strategies over recorded logs on the calling thread, with no
+ * EventBus: each event is read, handed to the strategies (dispatch_event,
+ * as StrategyManager does) and to a BarAggregator, whose closed bars are
+ * dispatched right after the tick that closed them, then the next event.
+ * At the end the open bars are flushed and every strategy is finalized.
+ *
+ *   md::BacktestDriver bt("logs/md_events.bin");
+ *   bt.add_strategy(&strat);
+ *   auto stats = bt.run();
+ *
+ * The same input always produces the same calls in the same order, so two
+ * runs can be diffed trade by trade. Events keep their recorded seq and
+ * ts_ns (the bus would restamp them on publish); bar events carry seq 0 and
+ * the bar's end_ts_ns, as BarBuilder publishes them; bars closed by the
+ * same tick come smallest timeframe first.
+ *
+ * feed() / finish() drive it from another source, e.g. a SyntheticFeed;
+ * feed() leaves out recorded bars as run() does (see BacktestConfig).
+ */
+class BacktestDriver {
+private :
+    std::vector<std::string> paths_;
+    BacktestConfig cfg_;
+    std::vector<IStrategy*> strategies_;
+    BarAggregator bars_;
+    BacktestStats stats_{};
+    std::vector<Event>* sink_{nullptr};   // collect(): store instead of dispatch
+    uint64_t rebuilt_topics_{0};   // topic_bit of each timeframe built here
+
+    void deliver(const Event& e);
+    void dispatch_bar(const Bar& b, Topic topic);
+    // The read loop of run(), over the logs or over their dataset cache.
+    void read_logs();
+    bool read_cached();
+public :
+    explicit BacktestDriver(const std::string& path, const BacktestConfig& cfg = {});
+    // Several logs, merged by ts_ns as EventReplay merges them.
+    explicit BacktestDriver(std::vector<std::string> paths, const BacktestConfig& cfg = {});
+
+    // No logs: for run(const EventDataset&) or feed() / finish().
+    BacktestDriver() : BacktestDriver(std::vector<std::string>{}) {}
+
+    BacktestDriver(const BacktestDriver&) = delete;
+    BacktestDriver& operator=(const BacktestDriver&) = delete;
+
+    void add_strategy(IStrategy* strat);
+
+    // Replays the logs through the strategies, then finish(). Each call
+    // starts with fresh bars and stats; strategy state is the caller's.
+    BacktestStats run();
+
+    // Runs the logs as run() does, but appends the events the strategies
+    // would have been handed (recorded events and built bars, in dispatch
+    // order) to out instead; nothing is finalized. See EventDataset.
+    BacktestStats collect(std::vector<Event>& out);
+
+    // Hands every event of data to the strategies, then finalizes them.
+    // Bars are already in data, so none are built.
+    BacktestStats run(const EventDataset& data);
+
+    // One event, in time order; bars are built from it if enabled.
+    void feed(const Event& e);
+    // Flushes open bars to the strategies and finalizes them.
+    void finish();
+
+    const BacktestStats& stats() const { return stats_; }
+};
+
+/*
+ * EventDataset
+ * ------------
+ * A recording loaded once into memory as the exact event sequence a
+ * BacktestDriver would dispatch, bars included, so many backtests can run
+ * over it without reading or aggregating again. Read-only after load();
+ * any number of threads may run over one dataset (see ParameterSweep).
+ */
+class EventDataset {
+private :
+    std::vector<Event> events_;
+    BacktestStats stats_{};
+public :
+    // Replaces the contents. False if nothing could be read.
+    bool load(const std::vector<std::string>& paths, const BacktestConfig& cfg = {});
+    bool load(const std::string& path, const BacktestConfig& cfg = {}) {
+        return load(std::vector<std::string>{path}, cfg);
+    }
+
+    const std::vector<Event>& events() const { return events_; }
+    std::size_t size() const { return events_.size(); }
+    bool empty() const { return events_.empty(); }
+    // Counts of the load (events, ticks, bars and its elapsed time).
+    const BacktestStats& stats() const { return stats_; }
+};
+
+}
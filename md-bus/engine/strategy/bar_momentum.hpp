@@ -48,7 +48,7 @@ public :
     //ignore the tick level data in this strategy
 
     void on_log(const std::string& msg, const Event& e) override {
-        log_debug("[BARMOM] log event seq={} msg={}", e.h.seq, msg);
+        MD_LOG_DEBUG("[BARMOM] log event seq={} msg={}", e.h.seq, msg);
     }
 
     void on_heartbeat(const Event& e) override {
@@ -62,7 +62,7 @@ public :
         window_.push(b);
         if(!window_.full()) return ;
         double mom = window_.momentum();
-        log_debug("[BARMOM] bar sym={} o={} h={} l={} c={} v={} mom={:.4f} seq={}",
+        MD_LOG_DEBUG("[BARMOM] bar sym={} o={} h={} l={} c={} v={} mom={:.4f} seq={}",
                   b.symbol, b.open, b.high, b.low, b.close, b.volume, mom, e.h.seq);
         if(!account_.has_open_position()) {
 
@@ -0,0 +1,79 @@
+#pragma once 
+
+#include <vector>
+
+#include "../common/event.hpp"
+#include "../common/event_io.hpp"
+#include "../common/log.hpp"
+#include "../common/trace.hpp"
+#include "strategy.hpp"
+
+namespace md {
+
+/**
+ * dispatch_event
+ * --------------
+ * Hands one event to every strategy, in order, through the callback for
+ * its topic:
+ *     MD_TICK        -> on_tick()
+ *     LOG            -> on_log()
+ *     HEARTBEAT      -> on_heartbeat()
+ *     BAR_*          -> on_bar()
+ * Other topics, and events whose payload does not match the topic, are
+ * dropped. Used by StrategyManager on the bus and by BacktestDriver
+ * without one, so both see the same calls for the same events.
+ */
+inline void dispatch_event(const Event& e, const std::vector<IStrategy*>& strategies) {
+    switch(e.h.topic) {
+        case Topic::MD_TICK : {
+            if(!std::holds_alternative<Tick>(e.p)) {
+                log_warn("dispatch_event: MD_TICK event without Tick payload (seq={})",
+                         e.h.seq);
+                return;
+            }
+            const Tick& t = std::get<Tick>(e.p);
+            for(auto *strat : strategies) {
+                MD_TRACE_SCOPE("on_tick", "strategy", e.h.seq);
+                strat->on_tick(t, e);
+            }
+            break;
+        }
+        case Topic::LOG: {
+            if(!std::holds_alternative<std::string>(e.p)) {
+                return;
+            }
+            const auto& msg = std::get<std::string>(e.p);
+            for(auto* strat : strategies) {
+                strat->on_log(msg, e);
+            }
+            break;
+        }
+        case Topic::HEARTBEAT: {
+            for(auto* strat : strategies) {
+                strat->on_heartbeat(e);
+            }
+            break;
+        }
+        case Topic::BAR_1S:
+        case Topic::BAR_1M:
+        case Topic::BAR_5M:
+        case Topic::BAR_CUSTOM: {
+            if(!std::holds_alternative<Bar>(e.p)) {
+                log_warn("dispatch_event: {} event without Bar payload (seq={})",
+                         to_string(e.h.topic), e.h.seq);
+                return;
+            }
+            const Bar&b = std::get<Bar>(e.p);
+            for(auto* strat : strategies) {
+                MD_TRACE_SCOPE("on_bar", "strategy", e.h.seq);
+                strat->on_bar(b, e);
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+}
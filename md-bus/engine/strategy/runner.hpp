@@ -5,7 +5,9 @@
 
 #include "../bus/bus.hpp"
 #include "../common/event.hpp"
+#include "../common/event_io.hpp"
 #include "../common/log.hpp"
+#include "../common/trace.hpp"
 #include "strategy.hpp"
 
 namespace md {
@@ -13,9 +15,11 @@ namespace md {
  * StrategyRunner
  * --------------
  * Bridges EventBus and IStrategy:
- *  - Subscribes to MD_TICK, LOG, HEARTBEAT.
+ *  - Subscribes to MD_TICK, LOG, HEARTBEAT and one bar topic (per mode).
  *  - Forwards events into the strategy callbacks.
  *  - Unsubscribes on destruction.
+ *  - Subscriptions are named "<strategy name>/<topic>" so slow-consumer
+ *    warnings and EventBus::print_sub_stats() point at the strategy.
  *
  * Usage:
  *   md::EventBus bus(...);
@@ -45,7 +49,9 @@ private :
     std::size_t sub_bar_{};
 
 public :
-    StrategyRunner(EventBus& bus, IStrategy& strat, StrategyMode mode = StrategyMode::Mixed)
+    // bar_topic: which bars on_bar() gets (BAR_1S, BAR_1M, ... see BarBuilder)
+    StrategyRunner(EventBus& bus, IStrategy& strat, StrategyMode mode = StrategyMode::Mixed,
+                   Topic bar_topic = Topic::BAR_1S)
         :bus_{bus}, strat_{strat}, mode_{mode}
     {
         //Tick
@@ -53,12 +59,13 @@ public :
             sub_ticks_ = bus.subscribe(Topic::MD_TICK, [this](const Event& e){
                 if(std::holds_alternative<Tick>(e.p)){
                     const auto& t = std::get<Tick>(e.p);
+                    MD_TRACE_SCOPE("on_tick", "strategy", e.h.seq);
                     strat_.on_tick(t, e);
                 }else {
                     log_warn("StrategyRunner: MD_TICK event without Tick payload (seq={})",
                                  e.h.seq);
                 }
-            });
+            }, strat_.name() + "/tick");
         }
 
         //LOG
@@ -68,24 +75,25 @@ public :
                     const auto& msg = std::get<std::string>(e.p);
                     strat_.on_log(msg, e);
                 }
-        });
+        }, strat_.name() + "/log");
 
         // Heartbeats
         sub_hb_ = bus_.subscribe(Topic::HEARTBEAT,
             [this](const Event& e) {
                 strat_.on_heartbeat(e);
-        });
+        }, strat_.name() + "/heartbeat");
         
         if(mode_ != StrategyMode::TickOnly){
-            sub_bar_ = bus_.subscribe(Topic::BAR_1S, [this](const Event& e){
+            sub_bar_ = bus_.subscribe(bar_topic, [this](const Event& e){
                 if(!std::holds_alternative<Bar>(e.p)) {
-                    log_warn("StrategyRunner: BAR_1S event without Bar payload (seq={})",
-                             e.h.seq);
+                    log_warn("StrategyRunner: {} event without Bar payload (seq={})",
+                             to_string(e.h.topic), e.h.seq);
                     return;
                 }
                 const Bar& b = std::get<Bar>(e.p);
+                MD_TRACE_SCOPE("on_bar", "strategy", e.h.seq);
                 strat_.on_bar(b, e);
-            });
+            }, strat_.name() + "/bar");
         }
     }
     ~StrategyRunner() {
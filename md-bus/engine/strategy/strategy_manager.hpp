@@ -2,11 +2,14 @@
 
 #include <vector>
 #include <memory>
+#include <string>
 
 #include "../bus/bus.hpp"
 #include "../common/event.hpp"
 #include "../common/log.hpp"
+#include "../common/trace.hpp"
 #include "strategy.hpp"
+#include "dispatch.hpp"
 
 namespace md{
 
@@ -21,7 +24,8 @@ namespace md{
  *     MD_TICK   -> on_tick()
  *     LOG       -> on_log()
  *     HEARTBEAT -> on_heartbeat()
- *     BAR_1S    -> on_bar()
+ *     BAR_*     -> on_bar()
+ *   (see dispatch_event, which BacktestDriver shares)
  * - finalize_all() calls strategy->finalize() on all.
  */
 
@@ -33,63 +37,7 @@ private :
     std::vector<IStrategy*> strategies_;
 
     void on_event(const Event& e) {
-        switch(e.h.topic) {
-            case Topic::MD_TICK : {
-                if(!std::holds_alternative<Tick>(e.p)) {
-                    log_warn("StrategyManager: MD_TICK event without Tick payload (seq={})",
-                             e.h.seq);
-                    return;
-                }
-                const Tick& t = std::get<Tick>(e.p);
-                for(auto *strat : strategies_) {
-                    strat->on_tick(t, e);
-                }
-                break;
-            }
-            case Topic::LOG: {
-                if(!std::holds_alternative<std::string>(e.p)) {
-                    return;
-                }
-                const auto& msg = std::get<std::string>(e.p);
-                for(auto* strat : strategies_) {
-                    strat->on_log(msg, e);
-                }
-                break;
-            }
-            case Topic::HEARTBEAT: {
-                for(auto* strat : strategies_) {
-                    strat->on_heartbeat(e);
-                }
-                break;
-            }
-            case Topic::BAR_1S: {
-                if(!std::holds_alternative<Bar>(e.p)) {
-                    log_warn("StrategyManager: BAR_1S event without Bar payload (seq={})",
-                             e.h.seq);
-                    return;
-                }
-                const Bar&b = std::get<Bar>(e.p);
-                for(auto* strat : strategies_) {
-                    strat->on_bar(b, e);
-                }
-                break;
-            }
-            case Topic::BAR_1M: {
-                if(!std::holds_alternative<Bar>(e.p)) {
-                    log_warn("StrategyManager: BAR_1M event without Bar payload (seq={})",
-                             e.h.seq);
-                    return;
-                }
-                const Bar&b = std::get<Bar>(e.p);
-                for(auto* strat : strategies_) {
-                    strat->on_bar(b, e);
-                }
-                break;
-            }
-            default: {
-                break;
-            }
-        }
+        dispatch_event(e, strategies_);
     }
 public:
     explicit StrategyManager(EventBus& bus)
@@ -108,9 +56,16 @@ public:
     void start() {
         if(started_) return;
         started_ = true;
+        // named after the strategies it fans out to, for bus stats / warnings
+        std::string name = "StrategyManager[";
+        for(std::size_t i = 0; i < strategies_.size(); ++i) {
+            if(i) name += ",";
+            name += strategies_[i]->name();
+        }
+        name += "]";
         sub_all_ = bus_.subscribe_all([this](const Event& e){
             this->on_event(e);
-        });
+        }, name);
         log_info("StrategyManager: started with {} strategies", strategies_.size());
     }
 
@@ -0,0 +1,99 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <fmt/core.h>
+
+#include "../common/log.hpp"
+
+namespace md {
+
+void ParameterSweep::add(std::string label, Factory make, double starting_cash) {
+    points_.push_back(Point{std::move(label), std::move(make), starting_cash});
+}
+
+SweepResult ParameterSweep::run_point(const Point& p, const EventDataset& data) {
+    SweepResult r;
+    r.label = p.label;
+    Account acct(p.starting_cash);
+    std::unique_ptr<IStrategy> strat = p.make(acct);
+    if(!strat) {
+        log_warn("ParameterSweep: '{}' built no strategy", p.label);
+        return r;
+    }
+
+    BacktestDriver drv;
+    drv.add_strategy(strat.get());
+    r.elapsed_ns = drv.run(data).elapsed_ns;
+
+    r.realized_pnl = acct.realized_pnl();
+    r.equity = acct.equity();
+    r.max_drawdown = acct.max_drawdown();
+    r.trades = acct.trades().size();
+    for(const auto& tr : acct.trades()) {
+        if(tr.pnl > 0) ++r.wins;
+    }
+    return r;
+}
+
+std::vector<SweepResult> ParameterSweep::run(const EventDataset& data, unsigned threads) const {
+    std::vector<SweepResult> results(points_.size());
+    if(points_.empty()) return results;
+
+    if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, points_.size()));
+
+    // Points go to whichever worker is free next; each writes only its own slot.
+    std::atomic<std::size_t> next{0};
+    auto work = [&]() {
+        for(std::size_t i = next.fetch_add(1); i < points_.size(); i = next.fetch_add(1)) {
+            results[i] = run_point(points_[i], data);
+        }
+    };
+
+    const uint64_t t0 = now_ns();
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for(unsigned t = 1; t < threads; ++t) pool.emplace_back(work);
+    work();
+    for(auto& th : pool) th.join();
+
+    log_info("ParameterSweep: {} points over {} events on {} threads in {} ms",
+             points_.size(), data.size(), threads, (now_ns() - t0) / 1'000'000);
+    return results;
+}
+
+void ParameterSweep::print_results(const std::vector<SweepResult>& results) {
+    fmt::print("{:<24} {:>14} {:>14} {:>12} {:>7} {:>8} {:>10}\n",
+               "point", "realized_pnl", "equity", "max_dd", "trades", "win%", "ms");
+    for(const auto& r : results) {
+        const double win_rate = r.trades ? 100.0 * static_cast<double>(r.wins) / r.trades : 0.0;
+        fmt::print("{:<24} {:>14.2f} {:>14.2f} {:>12.2f} {:>7} {:>7.1f}% {:>10.1f}\n",
+                   r.label, r.realized_pnl, r.equity, r.max_drawdown, r.trades,
+                   win_rate, r.elapsed_ns / 1e6);
+    }
+}
+
+bool ParameterSweep::dump_csv(const std::vector<SweepResult>& results, const std::string& path) {
+    std::ofstream out(path);
+    if(!out) {
+        log_error("ParameterSweep::dump_csv: failed to open '{}'", path);
+        return false;
+    }
+    out << "point,realized_pnl,equity,max_drawdown,trades,wins,elapsed_ns\n";
+    for(const auto& r : results) {
+        out << r.label << ","
+            << r.realized_pnl << ","
+            << r.equity << ","
+            << r.max_drawdown << ","
+            << r.trades << ","
+            << r.wins << ","
+            << r.elapsed_ns << "\n";
+    }
+    log_info("ParameterSweep: dumped {} results to '{}'", results.size(), path);
+    return true;
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "accounting.hpp"
+#include "backtest.hpp"
+#include "strategy.hpp"
+
+namespace md {
+
+// Summary of one grid point's backtest.
+struct SweepResult {
+    std::string label;
+    double realized_pnl{0.0};
+    double equity{0.0};
+    double max_drawdown{0.0};
+    std::size_t trades{0};
+    std::size_t wins{0};
+    uint64_t elapsed_ns{0};
+};
+
+/*
+ * ParameterSweep
+ * --------------
+ * Backtests a grid of strategy instances over one EventDataset, each with
+ * its own Account, spread over a pool of threads:
+ *
+ *   md::EventDataset data;
+ *   data.load("logs/md_events.bin", cfg);
+ *   md::ParameterSweep sweep;
+ *   for (std::size_t w : {5, 10, 20})
+ *       sweep.add(fmt::format("w={}", w), [=](md::Account& acct) {
+ *           return std::make_unique<md::BarMomentumStrategy>(acct, "NIFTY", w, 0.1, 1);
+ *       });
+ *   auto results = sweep.run(data);
+ *
+ * The dataset is read by every thread and written by none, and points share
+ * nothing else, so the sweep scales with cores until memory bandwidth runs
+ * out. Each point is a separate backtest (see BacktestDriver), so its result
+ * does not depend on the thread count or on the other points.
+ */
+class ParameterSweep {
+public :
+    using Factory = std::function<std::unique_ptr<IStrategy>(Account&)>;
+
+    // A grid point: label names it in the results, make builds its strategy
+    // on the account it will trade (called on the worker thread).
+    void add(std::string label, Factory make, double starting_cash = 0.0);
+
+    std::size_t size() const { return points_.size(); }
+
+    // Runs every point on `threads` threads (0 = all cores). Results are in
+    // add() order.
+    std::vector<SweepResult> run(const EventDataset& data, unsigned threads = 0) const;
+
+    static void print_results(const std::vector<SweepResult>& results);
+    static bool dump_csv(const std::vector<SweepResult>& results, const std::string& path);
+
+private :
+    struct Point {
+        std::string label;
+        Factory make;
+        double starting_cash;
+    };
+    std::vector<Point> points_;
+
+    static SweepResult run_point(const Point& p, const EventDataset& data);
+};
+
+}
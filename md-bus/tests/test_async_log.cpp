@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "../engine/common/log.hpp"
+
+using namespace md;
+
+TEST(AsyncLog, FormatsRecordsFromAllThreads) {
+  std::FILE* f = std::tmpfile();
+  ASSERT_NE(f, nullptr);
+
+  AsyncLogConfig cfg;
+  cfg.out = f;
+  cfg.ring_bytes = 1u << 20;
+  start_async_logging(cfg);
+
+  auto worker = [](int id) {
+    std::string sym = "NIFTY";
+    for (int i = 0; i < 1000; ++i) {
+      log_info("w={} sym={} px={} qty={} tag={}", id, sym, 22500.25, i, "lit");
+    }
+  };
+  std::thread a(worker, 1);
+  std::thread b(worker, 2);
+  a.join();
+  b.join();
+  stop_async_logging();
+
+  std::rewind(f);
+  char line[512];
+  int lines = 0;
+  bool found = false;
+  while (std::fgets(line, sizeof(line), f)) {
+    ++lines;
+    std::string s(line);
+    if (s.find("[INFO]") == 0 &&
+        s.find("w=2 sym=NIFTY px=22500.25 qty=999 tag=lit\n") != std::string::npos) {
+      found = true;
+    }
+  }
+  std::fclose(f);
+
+  EXPECT_EQ(lines, 2000);
+  EXPECT_TRUE(found);
+  EXPECT_EQ(async_log_dropped(), 0u);
+}
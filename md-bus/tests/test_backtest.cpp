@@ -0,0 +1,290 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+#include "../engine/common/event_index.hpp"
+#include "../engine/common/event_io.hpp"
+#include "../engine/record/recorder.hpp"
+#include "../engine/strategy/backtest.hpp"
+#include "../engine/strategy/bar_momentum.hpp"
+#include "../engine/strategy/sweep.hpp"
+
+using namespace md;
+
+namespace {
+
+// Records every callback in order.
+class TraceStrategy : public IStrategy {
+public:
+  std::vector<std::string> calls;
+  bool finalized{false};
+
+  void on_tick(const Tick& t, const Event& e) override {
+    calls.push_back(fmt::format("T {} {} {}", t.symbol, e.h.ts_ns, t.qty));
+  }
+  void on_log(const std::string& msg, const Event&) override {
+    calls.push_back("L " + msg);
+  }
+  void on_heartbeat(const Event& e) override {
+    calls.push_back(fmt::format("H {}", e.h.ts_ns));
+  }
+  void on_bar(const Bar& b, const Event& e) override {
+    calls.push_back(fmt::format("B {} {} {} {} {} {}", b.symbol, b.open, b.close,
+                                b.volume, b.start_ts_ns, e.h.ts_ns));
+  }
+  void finalize() override { finalized = true; }
+};
+
+// Two symbols, a tick each every 250 ms, plus a heartbeat per second (and
+// with recorded_bars an AAA BAR_1S event, as a live BarBuilder adds).
+void write_log(const std::string& path, uint64_t n, bool recorded_bars = false) {
+  std::remove(path.c_str());
+  EventRecorder rec(path, RecordFormat::Binary);
+  uint64_t seq = 0;
+  for (uint64_t i = 0; i < n; ++i) {
+    const uint64_t ts = 1'000'000'000 + i * 250'000'000;
+    for (const char* sym : {"AAA", "BBB"}) {
+      Event e;
+      e.h = {++seq, Topic::MD_TICK, ts};
+      // a saw tooth, so momentum strategies trade
+      e.p = Tick{sym, 100.0 + static_cast<double>(i % 12), static_cast<uint32_t>(i + 1)};
+      rec.on_event(e);
+    }
+    if (i % 4 == 3) {
+      Event hb;
+      hb.h = {++seq, Topic::HEARTBEAT, ts + 1};
+      rec.on_event(hb);
+    }
+    if (recorded_bars && i % 4 == 3) {
+      Bar b;
+      b.symbol = "AAA";
+      b.open = b.high = b.low = b.close = 1.0;
+      b.start_ts_ns = ts - 750'000'000;
+      b.end_ts_ns = ts + 2;
+      rec.on_event(BarAggregator::bar_event(b));
+    }
+  }
+  rec.close();
+}
+
+}  // namespace
+
+TEST(Backtest, DeterministicTicksThenBars) {
+  const std::string path = "logs/test_backtest.bin";
+  write_log(path, 12);
+
+  TraceStrategy a;
+  BacktestDriver bt(path);
+  bt.add_strategy(&a);
+  const BacktestStats st = bt.run();
+  EXPECT_EQ(st.events, 27u);
+  EXPECT_EQ(st.ticks, 24u);
+  EXPECT_EQ(st.bars, 6u);  // 3 buckets x 2 symbols, the last two by the flush
+  EXPECT_TRUE(a.finalized);
+  ASSERT_EQ(a.calls.size(), 33u);
+
+  // The first bar comes right after the tick that opened the next second.
+  EXPECT_EQ(a.calls[9], "T AAA 2000000000 5");
+  EXPECT_EQ(a.calls[10], "B AAA 100 103 10 1000000000 1999999999");
+  EXPECT_EQ(a.calls[11], "T BBB 2000000000 5");
+  EXPECT_EQ(a.calls[12], "B BBB 100 103 10 1000000000 1999999999");
+
+  // A second run over the same log makes exactly the same calls.
+  TraceStrategy b;
+  BacktestDriver bt2(path);
+  bt2.add_strategy(&b);
+  bt2.run();
+  EXPECT_EQ(a.calls, b.calls);
+
+  // Through the dataset cache: the same calls, from the columns.
+  BacktestConfig cached;
+  cached.use_cache = true;
+  cached.cache_dir = "logs/test_backtest_cache";
+  TraceStrategy d;
+  BacktestDriver bt4(path, cached);
+  bt4.add_strategy(&d);
+  bt4.run();
+  EXPECT_EQ(a.calls, d.calls);
+  std::filesystem::remove_all(cached.cache_dir);
+
+  // Filters apply before bars are built.
+  BacktestConfig cfg;
+  cfg.filter.add_symbol("BBB");
+  TraceStrategy c;
+  BacktestDriver bt3(path, cfg);
+  bt3.add_strategy(&c);
+  const BacktestStats st3 = bt3.run();
+  EXPECT_EQ(st3.ticks, 12u);
+  EXPECT_EQ(st3.bars, 3u);
+
+  // Bars recorded live are left out by default, from the log and from its
+  // cache: the rebuilt ones take their place. A topic filter brings them
+  // back.
+  write_log(path, 12, true);
+  TraceStrategy e, f;
+  BacktestDriver bt5(path);
+  bt5.add_strategy(&e);
+  EXPECT_EQ(bt5.run().events, 27u);
+  EXPECT_EQ(a.calls, e.calls);
+  BacktestDriver bt6(path, cached);
+  bt6.add_strategy(&f);
+  bt6.run();
+  EXPECT_EQ(a.calls, f.calls);
+  std::filesystem::remove_all(cached.cache_dir);
+
+  BacktestConfig with_recorded;
+  with_recorded.filter.add_topic(Topic::MD_TICK);
+  with_recorded.filter.add_topic(Topic::BAR_1S);
+  BacktestDriver bt7(path, with_recorded);
+  const BacktestStats st7 = bt7.run();
+  EXPECT_EQ(st7.events, 27u);  // 24 ticks, 3 recorded bars
+  EXPECT_EQ(st7.bars, 6u);
+
+  std::remove(path.c_str());
+  std::remove(index_path_for(path).c_str());
+}
+
+TEST(Backtest, SweepOverDatasetMatchesFileRuns) {
+  const std::string path = "logs/test_backtest_sweep.bin";
+  write_log(path, 400);
+
+  // A dataset replays exactly the calls a run over the file makes.
+  EventDataset data;
+  ASSERT_TRUE(data.load(path));
+  TraceStrategy from_file, from_data;
+  BacktestDriver file_run(path);
+  file_run.add_strategy(&from_file);
+  file_run.run();
+  BacktestDriver data_run;
+  data_run.add_strategy(&from_data);
+  data_run.run(data);
+  EXPECT_EQ(from_file.calls, from_data.calls);
+  EXPECT_EQ(data.size(), from_file.calls.size());
+
+  ParameterSweep sweep;
+  for (std::size_t w : {1, 2, 3}) {
+    for (double thr : {0.0, 0.5}) {
+      sweep.add(fmt::format("w={} thr={}", w, thr), [=](Account& acct) {
+        return std::make_unique<BarMomentumStrategy>(acct, "AAA", w, thr, 1);
+      });
+    }
+  }
+  const auto one = sweep.run(data, 1);
+  const auto many = sweep.run(data, 4);
+  ASSERT_EQ(one.size(), 6u);
+  ASSERT_EQ(many.size(), 6u);
+  for (std::size_t i = 0; i < one.size(); ++i) {
+    EXPECT_EQ(one[i].label, many[i].label);
+    EXPECT_EQ(one[i].trades, many[i].trades);
+    EXPECT_DOUBLE_EQ(one[i].realized_pnl, many[i].realized_pnl);
+  }
+
+  // Each point matches a standalone backtest of the same strategy.
+  Account acct;
+  BarMomentumStrategy strat(acct, "AAA", 2, 0.0, 1);
+  BacktestDriver single(path);
+  single.add_strategy(&strat);
+  single.run();
+  EXPECT_GT(acct.trades().size(), 0u);
+  EXPECT_EQ(one[2].trades, acct.trades().size());
+  EXPECT_DOUBLE_EQ(one[2].realized_pnl, acct.realized_pnl());
+
+  std::remove(path.c_str());
+  std::remove(index_path_for(path).c_str());
+}
+
+TEST(Backtest, RolledUpBarsMatchDirectAggregation) {
+  // Two symbols with irregular gaps over ~23 minutes, including a silent
+  // stretch longer than a 5m bucket.
+  std::vector<Event> ticks;
+  uint64_t ts = 1'000'000'000;
+  for (uint64_t i = 0; i < 4000; ++i) {
+    ts += 137'000'000 + (i % 7) * 61'000'000;
+    if (i == 2500) ts += 7 * BarAggregator::NS_PER_MIN;
+    Event e;
+    e.h = {i + 1, Topic::MD_TICK, ts};
+    e.p = Tick{i % 3 ? "AAA" : "BBB", 100.0 + static_cast<double>((i * 37) % 101) * 0.5,
+               static_cast<uint32_t>(i % 9 + 1)};
+    ticks.push_back(e);
+  }
+
+  const uint64_t m15 = 15 * BarAggregator::NS_PER_MIN;
+  std::vector<BarTimeframe> tfs = BarAggregator::standard_timeframes();
+  tfs.push_back({m15, Topic::BAR_CUSTOM});
+  BarAggregator multi(tfs);
+  EXPECT_FALSE(multi.add_timeframe({90 * BarAggregator::NS_PER_SEC + 1, Topic::BAR_CUSTOM}));
+  // BAR_CUSTOM already carries the 15m bars
+  EXPECT_FALSE(multi.add_timeframe({30 * BarAggregator::NS_PER_MIN, Topic::BAR_CUSTOM}));
+
+  auto key = [](const Bar& b) {
+    return fmt::format("{} {} {} {} {} {} {} {}", b.symbol, b.open, b.high, b.low, b.close,
+                       b.volume, b.start_ts_ns, b.end_ts_ns);
+  };
+  const std::size_t topics = static_cast<std::size_t>(Topic::BAR_CUSTOM) + 1;
+  std::vector<std::vector<std::string>> rolled(topics);
+  auto run = [&](BarAggregator& agg, std::vector<std::vector<std::string>>& out) {
+    auto emit = [&](const Bar& b, Topic t) { out[static_cast<int>(t)].push_back(key(b)); };
+    for (const auto& e : ticks) agg.on_tick(std::get<Tick>(e.p), e.h.ts_ns, emit);
+    agg.flush(emit);
+  };
+  run(multi, rolled);
+  for (const auto& tf : tfs) {
+    // one aggregator per timeframe, built from the ticks, publishing on tf.topic
+    BarAggregator single(tf.bucket_ns, tf.topic);
+    std::vector<std::vector<std::string>> out(topics);
+    run(single, out);
+    const int t = static_cast<int>(tf.topic);
+    std::sort(out[t].begin(), out[t].end());
+    std::sort(rolled[t].begin(), rolled[t].end());
+    EXPECT_EQ(rolled[t], out[t]) << to_string(tf.topic);
+    EXPECT_FALSE(out[t].empty());
+  }
+  EXPECT_GT(rolled[static_cast<int>(Topic::BAR_1M)].size(), 2 * rolled[static_cast<int>(Topic::BAR_5M)].size());
+
+  // Bars that close together come out smallest timeframe first, also when
+  // one (4s) rolls up from another rolled-up one (2s) ahead of a third (3s).
+  {
+    const uint64_t s = BarAggregator::NS_PER_SEC;
+    BarAggregator agg({{s, Topic::BAR_1S}, {2 * s, Topic::BAR_1M},
+                       {3 * s, Topic::BAR_5M}, {4 * s, Topic::BAR_CUSTOM}});
+    std::vector<Topic> order;
+    auto emit = [&](const Bar&, Topic t) { order.push_back(t); };
+    agg.on_tick(Tick{"AAA", 1.0, 1}, 11 * s, emit);
+    agg.on_tick(Tick{"AAA", 1.0, 1}, 12 * s, emit);
+    EXPECT_EQ(order, (std::vector<Topic>{Topic::BAR_1S, Topic::BAR_1M, Topic::BAR_5M,
+                                         Topic::BAR_CUSTOM}));
+  }
+
+  // Through the driver: every timeframe reaches on_bar, each on its topic.
+  const std::string path = "logs/test_backtest_tf.bin";
+  {
+    std::remove(path.c_str());
+    EventRecorder rec(path, RecordFormat::Binary);
+    for (const auto& e : ticks) rec.on_event(e);
+    rec.close();
+  }
+  class TopicCounter : public IStrategy {
+  public:
+    std::vector<uint64_t> bars;
+    void on_tick(const Tick&, const Event&) override {}
+    void on_log(const std::string&, const Event&) override {}
+    void on_heartbeat(const Event&) override {}
+    void on_bar(const Bar&, const Event& e) override { ++bars[static_cast<int>(e.h.topic)]; }
+  } counter;
+  counter.bars.assign(topics, 0);
+  BacktestConfig cfg;
+  cfg.timeframes = tfs;
+  BacktestDriver bt(path, cfg);
+  bt.add_strategy(&counter);
+  bt.run();
+  for (const auto& tf : tfs) {
+    const int t = static_cast<int>(tf.topic);
+    EXPECT_EQ(counter.bars[t], rolled[t].size()) << to_string(tf.topic);
+  }
+
+  std::remove(path.c_str());
+  std::remove(index_path_for(path).c_str());
+}
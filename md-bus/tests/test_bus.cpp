@@ -72,4 +72,53 @@ TEST(Bus, MultipleSubscribersIndependent) {
   bus.unsubscribe(tick_sub);
   bus.unsubscribe(log_sub);
   bus.stop();
-}
\ No newline at end of file
+}
+
+TEST(Bus, SlowConsumerIsReported) {
+  EventBus bus(64, 8);
+  bus.set_slow_callback_threshold(std::chrono::milliseconds(2));
+  bus.start_watchdog(md::Duration(10), 2);
+
+  // per-call threshold warnings and watchdog queue-growth reports
+  std::atomic<int> slow_calls{0};
+  std::atomic<int> slow_consumers{0};
+  auto warn_sub = bus.subscribe(Topic::LOG, [&](const Event& e){
+    if (std::holds_alternative<std::string>(e.p)) {
+      const auto& msg = std::get<std::string>(e.p);
+      if (msg.find("sub=slow-ticks") == std::string::npos) return;
+      if (msg.rfind("SLOW_CALLBACK ", 0) == 0) slow_calls.fetch_add(1, std::memory_order_relaxed);
+      if (msg.rfind("SLOW_CONSUMER ", 0) == 0) slow_consumers.fetch_add(1, std::memory_order_relaxed);
+    }
+  }, "warnings");
+
+  auto slow = bus.subscribe(Topic::MD_TICK, [&](const Event&){
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }, "slow-ticks");
+
+  Header h{};
+  h.topic = Topic::MD_TICK;
+  for (int i = 0; i < 20; ++i) {
+    Tick t{.symbol="X", .pq=1.0, .qty=1};
+    bus.publish(Event{ .h = h, .p = t });
+  }
+  // until all 20 callbacks have run and both kinds of warning arrived
+  auto stats = bus.sub_stats();
+  for (int i = 0; i < 2500; ++i) {
+    stats = bus.sub_stats();
+    if (stats.size() == 2 && stats[1].calls >= 20 && slow_calls.load() >= 1 &&
+        slow_consumers.load() >= 1) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+
+  ASSERT_EQ(stats.size(), 2u);
+  EXPECT_EQ(stats[1].name, "slow-ticks");
+  EXPECT_EQ(stats[1].calls, 20u);
+  EXPECT_GE(stats[1].p50_ns, 4'000'000u);
+  EXPECT_EQ(stats[1].slow_calls, 20u);
+  EXPECT_GE(slow_calls.load(), 1);
+  EXPECT_GE(slow_consumers.load(), 1);
+
+  bus.unsubscribe(slow);
+  bus.unsubscribe(warn_sub);
+  bus.stop();
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../engine/common/column_codec.hpp"
+#include "../engine/common/event_index.hpp"
+#include "../engine/gen/synthetic_feed.hpp"
+#include "../engine/replay/event_reader.hpp"
+
+using namespace md;
+
+static void expect_same(const Event& a, const Event& b) {
+  ASSERT_EQ(a.h.seq, b.h.seq);
+  ASSERT_EQ(a.h.ts_ns, b.h.ts_ns);
+  ASSERT_EQ(a.h.topic, b.h.topic);
+  ASSERT_EQ(a.p.index(), b.p.index());
+  if (const auto* t = std::get_if<Tick>(&a.p)) {
+    const auto& u = std::get<Tick>(b.p);
+    EXPECT_EQ(t->symbol, u.symbol);
+    EXPECT_EQ(t->pq, u.pq);
+    EXPECT_EQ(t->qty, u.qty);
+  } else if (const auto* x = std::get_if<Bar>(&a.p)) {
+    const auto& y = std::get<Bar>(b.p);
+    EXPECT_EQ(x->symbol, y.symbol);
+    EXPECT_EQ(x->open, y.open);
+    EXPECT_EQ(x->high, y.high);
+    EXPECT_EQ(x->low, y.low);
+    EXPECT_EQ(x->close, y.close);
+    EXPECT_EQ(x->volume, y.volume);
+    EXPECT_EQ(x->start_ts_ns, y.start_ts_ns);
+    EXPECT_EQ(x->end_ts_ns, y.end_ts_ns);
+  } else if (const auto* s = std::get_if<std::string>(&a.p)) {
+    EXPECT_EQ(*s, std::get<std::string>(b.p));
+  }
+}
+
+static std::vector<Event> round_trip(const std::vector<Event>& in, std::size_t block) {
+  ColumnBlockEncoder enc;
+  std::string buf;
+  for (const auto& e : in) {
+    enc.add(e);
+    if (enc.pending() == block) enc.encode_block(buf);
+  }
+  enc.encode_block(buf);
+  buf.append(kColumnPad, '\0');
+
+  ColumnBlockDecoder dec;
+  std::vector<Event> out, batch;
+  std::size_t pos = 0;
+  while (pos + kColumnBlockHeaderSize <= buf.size() - kColumnPad) {
+    uint32_t body = 0, n = 0;
+    read_column_block_header(buf.data() + pos, body, n);
+    pos += kColumnBlockHeaderSize;
+    EXPECT_TRUE(dec.decode_block(buf.data() + pos, body, n, batch));
+    out.insert(out.end(), batch.begin(), batch.end());
+    pos += body;
+  }
+  return out;
+}
+
+TEST(ColumnCodec, MixedPayloadsRoundTripExactly) {
+  std::vector<Event> in;
+  for (uint64_t i = 0; i < 300; ++i) {
+    Event e;
+    e.h = {100 + i, Topic::MD_TICK, 5'000'000'000ULL + i * 997};
+    e.p = Tick{i % 3 ? "NIFTY" : "BANKNIFTY", 22500.05 + 0.05 * static_cast<double>(i % 40), 75};
+    if (i % 50 == 7) {
+      e.h.topic = Topic::LOG;
+      e.p = std::string("note, with commas");
+    } else if (i % 50 == 9) {
+      e.h.topic = Topic::BAR_1S;
+      e.p = Bar{"NIFTY", 22500.05, 22501.5, 22499.95, 22500.55, 1234,
+                e.h.ts_ns - 1'000'000'000ULL, e.h.ts_ns - 1};
+    } else if (i % 50 == 11) {
+      e.h.topic = Topic::HEARTBEAT;
+      e.p = std::monostate{};
+    }
+    in.push_back(e);
+  }
+  // one block with a price that has no decimal tick form -> raw prices
+  in[210].p = Tick{"ODD", 1.0 / 3.0, 1};
+  in[211].h.ts_ns = in[210].h.ts_ns - 5; // ts going backwards
+
+  const auto out = round_trip(in, 64);
+  ASSERT_EQ(out.size(), in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) expect_same(in[i], out[i]);
+}
+
+TEST(ColumnCodec, RecorderFileIsMuchSmallerThanText) {
+  SyntheticConfig cfg;
+  cfg.total_events = 50'000;
+  cfg.num_symbols = 20;
+  const std::string text = "logs/test_cc.txt";
+  const std::string col = "logs/test_cc.mdcc";
+  SyntheticFeed(cfg).write_to_file(text, RecordFormat::Text);
+  SyntheticFeed(cfg).write_to_file(col, RecordFormat::Columnar);
+
+  EventFileReader a(text), b(col);
+  ASSERT_EQ(b.format(), RecordFormat::Columnar);
+  Event x, y;
+  uint64_t n = 0;
+  while (a.next(x)) {
+    ASSERT_TRUE(b.next(y));
+    expect_same(x, y);
+    ++n;
+  }
+  EXPECT_FALSE(b.next(y));
+  EXPECT_EQ(n, cfg.total_events);
+
+  const auto text_bytes = std::filesystem::file_size(text);
+  const auto col_bytes = std::filesystem::file_size(col);
+  EXPECT_LT(col_bytes * 6, text_bytes) << text_bytes << " vs " << col_bytes;
+
+  for (const auto& p : {text, col}) {
+    std::remove(p.c_str());
+    std::remove(index_path_for(p).c_str());
+  }
+}
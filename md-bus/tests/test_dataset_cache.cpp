@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../engine/common/event_index.hpp"
+#include "../engine/record/log_convert.hpp"
+#include "../engine/record/recorder.hpp"
+#include "../engine/replay/dataset_cache.hpp"
+#include "../engine/replay/event_reader.hpp"
+#include "../engine/replay/replay.hpp"
+
+using namespace md;
+
+namespace {
+
+// Ticks on three symbols with a log line, a heartbeat and a bar now and then.
+void write_mixed_log(const std::string& path, uint64_t n, double px0 = 100.0) {
+  std::remove(path.c_str());
+  EventRecorder rec(path, RecordFormat::Text);
+  const char* syms[] = {"AAA", "BBB", "CCC"};
+  uint64_t seq = 0;
+  for (uint64_t i = 0; i < n; ++i) {
+    const uint64_t ts = 1'000'000'000 + i * 1'000'000;
+    Event e;
+    e.h = {++seq, Topic::MD_TICK, ts};
+    e.p = Tick{syms[i % 3], px0 + static_cast<double>(i % 50) * 0.25, static_cast<uint32_t>(i % 7 + 1)};
+    rec.on_event(e);
+    if (i % 100 == 0) {
+      Event l;
+      l.h = {++seq, Topic::LOG, ts};
+      l.p = std::string("checkpoint ") + std::to_string(i);
+      rec.on_event(l);
+      Event hb;
+      hb.h = {++seq, Topic::HEARTBEAT, ts};
+      rec.on_event(hb);
+      Event b;
+      b.h = {++seq, Topic::BAR_1S, ts};
+      b.p = Bar{"BBB", 1.0, 2.5, 3.0, 0.5, static_cast<int>(i), ts - 1000, ts};
+      rec.on_event(b);
+    }
+  }
+  rec.close();
+}
+
+std::vector<Event> scan_all(const std::function<uint64_t(const std::function<bool(Event&)>&)>& scan) {
+  std::vector<Event> out;
+  scan([&](Event& e) {
+    out.push_back(e);
+    return true;
+  });
+  return out;
+}
+
+void expect_same(const std::vector<Event>& a, const std::vector<Event>& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    ASSERT_TRUE(same_event(a[i], b[i])) << "event " << i;
+  }
+}
+
+}  // namespace
+
+TEST(DatasetCache, BuildsOnceAndMatchesTheLog) {
+  namespace fs = std::filesystem;
+  const std::string path = "logs/test_dataset.log";
+  const std::string dir = "logs/test_dataset_cache";
+  fs::remove_all(dir);
+  write_mixed_log(path, 3000);
+
+  ColumnDataset d;
+  ASSERT_TRUE(d.open(path, dir));
+  EXPECT_TRUE(d.built());
+  EXPECT_EQ(d.size(), 3000u + 3 * 30);
+  EXPECT_EQ(d.symbols(), (std::vector<std::string>{"AAA", "BBB", "CCC"}));
+  const std::string first_cache = d.cache_path();
+
+  ColumnDataset again;
+  ASSERT_TRUE(again.open(path, dir));
+  EXPECT_FALSE(again.built());
+  EXPECT_EQ(again.cache_path(), first_cache);
+
+  // Every event, and every filtered / positioned scan, matches the log.
+  const ReplayFilter none;
+  expect_same(scan_all([&](auto& fn) { return scan_events(path, none, fn); }),
+              scan_all([&](auto& fn) { return scan_dataset(again, none, fn); }));
+
+  ReplayFilter f;
+  f.add_symbol("CCC");
+  f.add_symbol("AAA");
+  f.filter_by_time = true;
+  f.ts_min = 1'500'000'000;
+  f.ts_max = 3'000'000'000;
+  const ReplayStart from_seq{ReplayStart::From::Seq, 900, 0};
+  expect_same(scan_all([&](auto& fn) { return scan_events(path, f, fn, from_seq); }),
+              scan_all([&](auto& fn) { return scan_dataset(again, f, fn, from_seq); }));
+
+  ReplayFilter logs;
+  logs.add_topic(Topic::LOG);
+  logs.add_topic(Topic::BAR_1S);
+  const ReplayStart after{ReplayStart::From::After, 500, 1'400'000'000};
+  const auto cached = scan_all([&](auto& fn) { return scan_dataset(again, logs, fn, after); });
+  expect_same(scan_all([&](auto& fn) { return scan_events(path, logs, fn, after); }), cached);
+  ASSERT_FALSE(cached.empty());
+  EXPECT_EQ(std::get<std::string>(cached.front().p), "checkpoint 500");
+
+  // A changed log gets a new cache; the old one is removed.
+  write_mixed_log(path, 3000, 200.0);
+  ColumnDataset changed;
+  ASSERT_TRUE(changed.open(path, dir));
+  EXPECT_TRUE(changed.built());
+  EXPECT_NE(changed.cache_path(), first_cache);
+  EXPECT_FALSE(fs::exists(first_cache));
+  Event e;
+  changed.event_at(0, e);
+  EXPECT_DOUBLE_EQ(std::get<Tick>(e.p).pq, 200.0);
+
+  std::remove(path.c_str());
+  std::remove(index_path_for(path).c_str());
+  fs::remove_all(dir);
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../engine/common/event_binary.hpp"
+#include "../engine/record/recorder.hpp"
+#include "../engine/replay/event_reader.hpp"
+
+using namespace md;
+
+static Event make_tick(uint64_t seq, uint64_t ts, const std::string& sym, double px, uint32_t qty) {
+  Event e;
+  e.h.seq = seq;
+  e.h.topic = Topic::MD_TICK;
+  e.h.ts_ns = ts;
+  e.p = Tick{sym, px, qty};
+  return e;
+}
+
+TEST(EventBinary, RoundTripsEveryPayloadKind) {
+  std::vector<Event> in;
+  in.push_back(make_tick(10, 1'000'000, "NIFTY", 22500.05, 75));
+  in.push_back(make_tick(11, 1'000'500, "BANKNIFTY", 0.1 + 0.2, 15));
+  in.push_back(make_tick(12, 999'000, "NIFTY", -1.5, 0)); // ts goes backwards
+
+  Event log;
+  log.h = {13, Topic::LOG, 1'002'000};
+  log.p = std::string("a, b, c");
+  in.push_back(log);
+
+  Event bar;
+  bar.h = {14, Topic::BAR_1S, 2'000'000};
+  bar.p = Bar{"NIFTY", 1.25, 2.5, 3.75, 0.5, 123, 1'000'000, 1'999'999};
+  in.push_back(bar);
+
+  Event empty;
+  empty.h = {20, Topic::HEARTBEAT, 2'000'100};
+  in.push_back(empty);
+
+  BinaryEventWriter w;
+  std::string buf;
+  write_binary_file_header(buf);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    if (i == 3) w.sync(buf);
+    w.encode(in[i], buf);
+  }
+  EXPECT_EQ(w.symbol_count(), 2u);
+
+  uint16_t flags = 1;
+  ASSERT_TRUE(read_binary_file_header(buf, flags));
+  EXPECT_EQ(flags, 0);
+
+  BinaryEventReader r;
+  const char* p = buf.data() + kBinaryFileHeaderSize;
+  const char* end = buf.data() + buf.size();
+  for (const auto& want : in) {
+    Event got;
+    std::size_t used = 0;
+    ASSERT_EQ(r.decode(p, end, got, used), DecodeStatus::Event);
+    p += used;
+    EXPECT_EQ(got.h.seq, want.h.seq);
+    EXPECT_EQ(got.h.topic, want.h.topic);
+    EXPECT_EQ(got.h.ts_ns, want.h.ts_ns);
+    EXPECT_EQ(got.p.index(), want.p.index());
+    if (const auto* t = std::get_if<Tick>(&want.p)) {
+      const auto& g = std::get<Tick>(got.p);
+      EXPECT_EQ(g.symbol, t->symbol);
+      EXPECT_EQ(g.pq, t->pq); // bit-exact
+      EXPECT_EQ(g.qty, t->qty);
+    } else if (const auto* b = std::get_if<Bar>(&want.p)) {
+      const auto& g = std::get<Bar>(got.p);
+      EXPECT_EQ(g.symbol, b->symbol);
+      EXPECT_EQ(g.open, b->open);
+      EXPECT_EQ(g.high, b->high);
+      EXPECT_EQ(g.low, b->low);
+      EXPECT_EQ(g.close, b->close);
+      EXPECT_EQ(g.volume, b->volume);
+      EXPECT_EQ(g.start_ts_ns, b->start_ts_ns);
+      EXPECT_EQ(g.end_ts_ns, b->end_ts_ns);
+    } else if (const auto* s = std::get_if<std::string>(&want.p)) {
+      EXPECT_EQ(std::get<std::string>(got.p), *s);
+    }
+  }
+  Event tail;
+  std::size_t used = 0;
+  EXPECT_EQ(r.decode(p, end, tail, used), DecodeStatus::End);
+}
+
+TEST(EventBinary, TornTailIsReportedAsTruncated) {
+  BinaryEventWriter w;
+  std::string buf;
+  w.encode(make_tick(1, 100, "NIFTY", 1.0, 1), buf);
+  const std::size_t first = buf.size();
+  w.encode(make_tick(2, 200, "NIFTY", 2.0, 2), buf);
+  buf.resize(buf.size() - 3);
+
+  BinaryEventReader r;
+  Event e;
+  std::size_t used = 0;
+  ASSERT_EQ(r.decode(buf.data(), buf.data() + buf.size(), e, used), DecodeStatus::Event);
+  EXPECT_EQ(used, first);
+  EXPECT_EQ(r.decode(buf.data() + used, buf.data() + buf.size(), e, used), DecodeStatus::Truncated);
+}
+
+TEST(EventBinary, Crc32cMatchesReferenceAndChains) {
+  const std::string s = "123456789";
+  EXPECT_EQ(crc32c(s.data(), s.size()), 0xe3069283u);
+  EXPECT_EQ(crc32c(s.data() + 4, 5, crc32c(s.data(), 4)), 0xe3069283u);
+  const std::string long_s(1000, 'x'); // exercises the 8-byte loop
+  EXPECT_EQ(crc32c(long_s.data() + 3, 997, crc32c(long_s.data(), 3)), crc32c(long_s.data(), 1000));
+}
+
+TEST(EventBinary, ChecksummedRecordsRejectBitFlips) {
+  BinaryEventWriter w;
+  w.set_checksums(true);
+  std::string buf;
+  w.encode(make_tick(1, 100, "NIFTY", 1.0, 1), buf);
+
+  BinaryEventReader r;
+  r.set_checksums(true);
+  Event e;
+  std::size_t used = 0;
+  ASSERT_EQ(r.decode(buf.data(), buf.data() + buf.size(), e, used), DecodeStatus::Event);
+  EXPECT_EQ(used, buf.size());
+
+  buf[buf.size() - 6] ^= 0x01; // inside the f64 price
+  BinaryEventReader r2;
+  r2.set_checksums(true);
+  EXPECT_EQ(r2.decode(buf.data(), buf.data() + buf.size(), e, used), DecodeStatus::Corrupt);
+}
+
+TEST(EventBinary, RecorderAndReaderAgreeOnBothFormats) {
+  for (auto fmt : {RecordFormat::Text, RecordFormat::Binary}) {
+    const std::string path = fmt == RecordFormat::Text ? "logs/test_rt.txt" : "logs/test_rt.bin";
+    {
+      EventRecorder rec(path, fmt);
+      for (uint64_t i = 1; i <= 1000; ++i) {
+        rec.on_event(make_tick(i, 1'000 * i, i % 2 ? "A" : "B", 100.0 + 0.01 * i, i));
+      }
+    }
+
+    EventFileReader r(path);
+    ASSERT_TRUE(r.ok());
+    EXPECT_EQ(r.format(), fmt);
+    Event e;
+    uint64_t n = 0;
+    while (r.next(e)) {
+      ++n;
+      EXPECT_EQ(e.h.seq, n);
+      EXPECT_EQ(std::get<Tick>(e.p).pq, 100.0 + 0.01 * n);
+    }
+    EXPECT_EQ(n, 1000u);
+    EXPECT_EQ(r.parse_errors(), 0u);
+    std::remove(path.c_str());
+  }
+}
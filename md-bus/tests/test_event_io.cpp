@@ -1,6 +1,14 @@
 #include <gtest/gtest.h>
-#include "../common/event.hpp"
-#include "../common/event_io.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "../engine/common/event.hpp"
+#include "../engine/common/byte_scan.hpp"
+#include "../engine/common/event_io.hpp"
+#include "../engine/record/recorder.hpp"
+#include "../engine/replay/event_reader.hpp"
 
 TEST(EventIo, SerializeTick) {
     md::Event e;
@@ -19,7 +27,7 @@ TEST(EventIo, SerializeTick) {
     EXPECT_NE(s.find("42"), std::string::npos);
     EXPECT_NE(s.find("1234567890"), std::string::npos);
     EXPECT_NE(s.find("MD_TICK"), std::string::npos);
-    EXPECT_NE(s.find("NIFTY", std::string::npos));
+    EXPECT_NE(s.find("NIFTY"), std::string::npos);
 }
 
 TEST(EventIo, SerializeLog){
@@ -36,4 +44,203 @@ TEST(EventIo, SerializeLog){
     EXPECT_NE(s.find("LOG"), std::string::npos);
     EXPECT_NE(s.find("Hello World"), std::string::npos);
 
-}
\ No newline at end of file
+}
+
+TEST(EventIo, ParseRoundTripsEveryPayload){
+    md::Event in;
+    in.h.seq = 18446744073709551615ull;
+    in.h.ts_ns = 1700000000123456789ull;
+
+    md::Event out;
+    in.h.topic = md::Topic::MD_TICK;
+    in.p = md::Tick{"NIFTY", 22500.05, 4294967295u};
+    ASSERT_TRUE(md::parse_event(md::serialize_event(in), out));
+    EXPECT_EQ(out.h.seq, in.h.seq);
+    EXPECT_EQ(out.h.ts_ns, in.h.ts_ns);
+    EXPECT_EQ(out.h.topic, in.h.topic);
+    const auto& t = std::get<md::Tick>(out.p);
+    EXPECT_EQ(t.symbol, "NIFTY");
+    EXPECT_EQ(t.pq, 22500.05);
+    EXPECT_EQ(t.qty, 4294967295u);
+
+    in.h.topic = md::Topic::BAR_1M;
+    in.p = md::Bar{"BANKNIFTY", 0.1, 0.3, 0.2, 1e-7, -5, 10, 20};
+    ASSERT_TRUE(md::parse_event(md::serialize_event(in), out));
+    const auto& b = std::get<md::Bar>(out.p);
+    EXPECT_EQ(b.symbol, "BANKNIFTY");
+    EXPECT_EQ(b.open, 0.1);
+    EXPECT_EQ(b.close, 0.3);
+    EXPECT_EQ(b.high, 0.2);
+    EXPECT_EQ(b.low, 1e-7);
+    EXPECT_EQ(b.volume, -5);
+    EXPECT_EQ(b.start_ts_ns, 10u);
+    EXPECT_EQ(b.end_ts_ns, 20u);
+
+    in.h.topic = md::Topic::LOG;
+    in.p = std::string("text, with, commas");
+    ASSERT_TRUE(md::parse_event(md::serialize_event(in), out));
+    EXPECT_EQ(std::get<std::string>(out.p), "text, with, commas");
+
+    in.h.topic = md::Topic::HEARTBEAT;
+    in.p = std::monostate{};
+    ASSERT_TRUE(md::parse_event(md::serialize_event(in), out));
+    EXPECT_TRUE(std::holds_alternative<std::monostate>(out.p));
+}
+
+TEST(EventIo, ParseRejectsMalformedLines){
+    md::Event out;
+    EXPECT_FALSE(md::parse_event("", out));
+    EXPECT_FALSE(md::parse_event("1,2,MD_TICK", out));
+    EXPECT_FALSE(md::parse_event("x,2,MD_TICK,-", out));
+    EXPECT_FALSE(md::parse_event("1,2x,MD_TICK,-", out));
+    EXPECT_FALSE(md::parse_event("-1,2,MD_TICK,-", out));
+    EXPECT_FALSE(md::parse_event("1,2,NOPE,-", out));
+    EXPECT_FALSE(md::parse_event("1,2,MD_TICK,TICK|A|1.5", out));
+    EXPECT_FALSE(md::parse_event("1,2,MD_TICK,TICK|A|1.5|abc", out));
+    EXPECT_FALSE(md::parse_event("1,2,MD_TICK,TICK|A|1.5|99999999999", out));
+    EXPECT_FALSE(md::parse_event("1,2,BAR_1S,BAR|A|1|2|3|4|5|6", out));
+    EXPECT_TRUE(md::parse_event("1,2,MD_TICK,TICK|A|1.5|7", out));
+}
+
+TEST(EventIo, FindByteMatchesScalarSearch){
+    std::string s(300, 'a');
+    for (std::size_t hit : {0ul, 1ul, 15ul, 16ul, 31ul, 32ul, 33ul, 200ul, 299ul}) {
+        for (std::size_t from : {0ul, 1ul, 7ul}) {
+            std::string t = s;
+            t[hit] = '\n';
+            const char* end = t.data() + t.size();
+            const char* want = std::find(static_cast<const char*>(t.data()) + from, end, '\n');
+            EXPECT_EQ(md::find_byte(t.data() + from, end, '\n'), want) << hit << " " << from;
+        }
+    }
+    EXPECT_EQ(md::find_byte(std::string_view(s), '\n'), std::string_view::npos);
+}
+
+TEST(EventIo, TextReaderHandlesLongAndUnterminatedLines){
+    std::filesystem::create_directories("logs");
+    const std::string path = "logs/test_event_io.txt";
+    md::Event e;
+    e.h.topic = md::Topic::LOG;
+    const std::string big(3u << 20, 'x'); // spans several read chunks
+    {
+        std::ofstream out(path, std::ios::binary);
+        for (uint64_t i = 1; i <= 3; ++i) {
+            e.h.seq = i;
+            e.p = i == 2 ? big : std::string("short");
+            out << md::serialize_event(e) << (i < 3 ? "\n" : ""); // no final newline
+        }
+    }
+
+    md::EventFileReader r(path);
+    std::vector<uint64_t> offsets;
+    uint64_t n = 0;
+    while (r.next(e)) {
+        ++n;
+        offsets.push_back(r.record_offset());
+        EXPECT_EQ(e.h.seq, n);
+        EXPECT_EQ(std::get<std::string>(e.p).size(), n == 2 ? big.size() : 5u);
+    }
+    EXPECT_EQ(n, 3u);
+    EXPECT_EQ(r.parse_errors(), 0u);
+
+    ASSERT_TRUE(r.seek(offsets[2]));
+    ASSERT_TRUE(r.next(e));
+    EXPECT_EQ(e.h.seq, 3u);
+    EXPECT_FALSE(r.next(e));
+    std::remove(path.c_str());
+}
+
+TEST(EventIo, MappedReaderMatchesStreamReaderAndFollowsGrowth){
+    for (auto fmt : {md::RecordFormat::Text, md::RecordFormat::Binary, md::RecordFormat::Columnar}) {
+        const std::string path = std::string("logs/test_mapped.") + md::to_string(fmt);
+        md::RecorderConfig rcfg;
+        rcfg.column_block_events = 256;
+        md::EventRecorder rec(path, fmt, rcfg);
+        md::Event e;
+        for (uint64_t i = 1; i <= 20000; ++i) {
+            e.h = {i, md::Topic::MD_TICK, 1000 * i};
+            e.p = md::Tick{i % 3 ? "AAA" : "BBB", 100.0 + 0.25 * static_cast<double>(i % 40), static_cast<uint32_t>(i)};
+            rec.on_event(e);
+        }
+        rec.flush();
+
+        md::EventReaderConfig small;
+        small.readahead_bytes = 4096; // release / prefetch many times over
+        md::EventReaderConfig stream;
+        stream.use_mmap = false;
+        md::EventFileReader a(path, small), b(path, stream);
+        EXPECT_TRUE(a.mapped());
+        EXPECT_FALSE(b.mapped());
+        md::Event x, y;
+        uint64_t n = 0;
+        while (a.next(x)) {
+            ASSERT_TRUE(b.next(y));
+            ASSERT_EQ(x.h.seq, y.h.seq);
+            ASSERT_EQ(std::get<md::Tick>(x.p).pq, std::get<md::Tick>(y.p).pq);
+            ASSERT_EQ(a.offset(), b.offset());
+            ++n;
+        }
+        EXPECT_FALSE(b.next(y));
+        EXPECT_EQ(n, 20000u) << md::to_string(fmt);
+
+        // data appended after the mapping reached its end is picked up
+        e.h = {20001, md::Topic::MD_TICK, 20001000};
+        rec.on_event(e);
+        rec.close();
+        ASSERT_TRUE(a.next(x)) << md::to_string(fmt);
+        EXPECT_EQ(x.h.seq, 20001u);
+
+        std::remove(path.c_str());
+        std::remove(md::index_path_for(path).c_str());
+    }
+}
+
+TEST(EventIo, SeekToTsAndSeqWithAndWithoutIndex){
+    // pairs of events share a timestamp; index blocks of 500 events
+    // (columnar: codec blocks of 500) so ties straddle block edges
+    for (auto fmt : {md::RecordFormat::Text, md::RecordFormat::Binary, md::RecordFormat::Columnar}) {
+        const std::string path = std::string("logs/test_seek.") + md::to_string(fmt);
+        {
+            md::RecorderConfig rcfg;
+            rcfg.index_block_events = 500;
+            rcfg.column_block_events = 500;
+            md::EventRecorder rec(path, fmt, rcfg);
+            md::Event e;
+            for (uint64_t i = 1; i <= 30001; ++i) {
+                e.h = {i, md::Topic::MD_TICK, 1'000 * (i / 2)};
+                e.p = md::Tick{i % 2 ? "AAA" : "BBB", 100.0, static_cast<uint32_t>(i)};
+                rec.on_event(e);
+            }
+        }
+        for (bool indexed : {true, false}) {
+            if (!indexed) std::remove(md::index_path_for(path).c_str());
+            const auto what = std::string(md::to_string(fmt)) + (indexed ? " indexed" : " no index");
+            md::EventFileReader r(path);
+            md::Event e;
+
+            // ts 7'500'000 first appears at seq 15000
+            ASSERT_TRUE(r.seek_to_ts(7'500'000)) << what;
+            ASSERT_TRUE(r.next(e));
+            EXPECT_EQ(e.h.seq, 15000u) << what;
+            ASSERT_TRUE(r.next(e));
+            EXPECT_EQ(e.h.seq, 15001u) << what;
+
+            // backwards, and onto the 500-event block edge
+            ASSERT_TRUE(r.seek_to_seq(501)) << what;
+            ASSERT_TRUE(r.next(e));
+            EXPECT_EQ(e.h.seq, 501u) << what;
+            EXPECT_EQ(std::get<md::Tick>(e.p).qty, 501u) << what;
+
+            ASSERT_TRUE(r.seek_to_ts(1)) << what;  // between ts 0 and 1000
+            ASSERT_TRUE(r.next(e));
+            EXPECT_EQ(e.h.seq, 2u) << what;
+
+            ASSERT_TRUE(r.seek_to_seq(30001)) << what;
+            ASSERT_TRUE(r.next(e));
+            EXPECT_FALSE(r.next(e)) << what;
+            EXPECT_FALSE(r.seek_to_ts(20'000'000)) << what;
+            EXPECT_EQ(r.parse_errors(), 0u) << what;
+        }
+        std::remove(path.c_str());
+    }
+}
@@ -0,0 +1,300 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../engine/record/recorder.hpp"
+#include "../engine/replay/event_reader.hpp"
+#include "../engine/replay/replay.hpp"
+
+using namespace md;
+
+static uint64_t count_events(const std::string& path) {
+  EventFileReader r(path);
+  Event e;
+  uint64_t n = 0;
+  while (r.next(e)) ++n;
+  return n;
+}
+
+static Event tick(uint64_t seq) {
+  Event e;
+  e.h = {seq, Topic::MD_TICK, 1'000 * seq};
+  e.p = Tick{"NIFTY", 22500.0 + 0.05 * static_cast<double>(seq), static_cast<uint32_t>(seq)};
+  return e;
+}
+
+TEST(Recorder, FlushMakesEverythingVisible) {
+  const std::string path = "logs/test_recorder_flush.log";
+  RecorderConfig cfg;
+  cfg.flush_bytes = 1u << 30;                        // never swap on size
+  cfg.flush_interval = std::chrono::milliseconds(60'000);
+  cfg.fsync = FsyncPolicy::EveryFlush;
+
+  EventRecorder rec(path, RecordFormat::Text, cfg);
+  for (uint64_t i = 1; i <= 500; ++i) rec.on_event(tick(i));
+  rec.flush();
+  EXPECT_EQ(count_events(path), 500u);
+
+  for (uint64_t i = 501; i <= 600; ++i) rec.on_event(tick(i));
+  rec.close();
+  rec.on_event(tick(601)); // ignored after close
+  EXPECT_EQ(count_events(path), 600u);
+  std::remove(path.c_str());
+}
+
+TEST(Recorder, SmallBuffersAndManyProducers) {
+  const std::string path = "logs/test_recorder_mt.bin";
+  RecorderConfig cfg;
+  cfg.flush_bytes = 256; // force frequent swaps while producers keep appending
+  cfg.flush_interval = std::chrono::milliseconds(1);
+
+  {
+    EventRecorder rec(path, RecordFormat::Binary, cfg);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+      producers.emplace_back([&rec, t] {
+        for (uint64_t i = 0; i < 5000; ++i) rec.on_event(tick(t * 5000 + i + 1));
+      });
+    }
+    for (auto& th : producers) th.join();
+  }
+  EXPECT_EQ(count_events(path), 20000u);
+  std::remove(path.c_str());
+}
+
+TEST(Recorder, IndexedScanMatchesFullScan) {
+  for (auto fmt : {RecordFormat::Text, RecordFormat::Binary}) {
+    const std::string path = fmt == RecordFormat::Text ? "logs/test_index.txt" : "logs/test_index.bin";
+    RecorderConfig cfg;
+    cfg.index_block_events = 64;
+    EventRecorder rec(path, fmt, cfg);
+    for (uint64_t i = 1; i <= 3000; ++i) {
+      Event e = tick(i);
+      std::get<Tick>(e.p).symbol = i % 100 == 0 ? "RARE" : "COMMON";
+      rec.on_event(e);
+      if (i == 2000) rec.flush(); // index written mid-block, tail keeps growing
+    }
+    rec.flush();
+    for (uint64_t i = 3001; i <= 3010; ++i) rec.on_event(tick(i)); // past the index
+
+    EventIndex idx;
+    ASSERT_TRUE(idx.load_for(path));
+    EXPECT_GT(idx.blocks().size(), 40u);
+
+    ReplayFilter f;
+    f.filter_by_symbol = true;
+    f.symbol = "RARE";
+    f.filter_by_time = true;
+    f.ts_min = 500'000;
+    f.ts_max = 2'500'000;
+    std::vector<uint64_t> seqs;
+    scan_events(path, f, [&](Event& e) { seqs.push_back(e.h.seq); return true; });
+    ASSERT_EQ(seqs.size(), 21u); // seq 500, 600, ..., 2500
+    EXPECT_EQ(seqs.front(), 500u);
+    EXPECT_EQ(seqs.back(), 2500u);
+
+    ReplayFilter late;
+    late.filter_by_time = true;
+    late.ts_min = 3'005'000;
+    rec.close();
+    EXPECT_EQ(scan_events(path, late, [](Event&) { return true; }), 6u);
+
+    std::remove(path.c_str());
+    std::remove(index_path_for(path).c_str());
+  }
+}
+
+static std::vector<uint64_t> read_seqs(const std::string& path, uint64_t* errors = nullptr) {
+  EventFileReader r(path);
+  std::vector<uint64_t> seqs;
+  Event e;
+  while (r.next(e)) seqs.push_back(e.h.seq);
+  if (errors) *errors = r.parse_errors();
+  return seqs;
+}
+
+TEST(Recorder, AppendRepairsTornTailAndContinues) {
+  for (auto fmt : {RecordFormat::Text, RecordFormat::Binary, RecordFormat::Columnar}) {
+    const std::string path = std::string("logs/test_append.") + to_string(fmt);
+    RecorderConfig cfg;
+    cfg.checksums = true;
+    cfg.index_block_events = 64;
+    cfg.column_block_events = 100;
+    auto ev = [](uint64_t i) {
+      Event e = tick(i);
+      std::get<Tick>(e.p).symbol = i > 1000 && i % 10 == 0 ? "NEW" : "S" + std::to_string(i % 7);
+      return e;
+    };
+    {
+      EventRecorder rec(path, fmt, cfg);
+      for (uint64_t i = 1; i <= 1000; ++i) rec.on_event(ev(i));
+    }
+    {
+      // a crash mid-write leaves part of a record behind
+      std::ofstream out(path, std::ios::binary | std::ios::app);
+      if (fmt == RecordFormat::Text) out << "1001,1001000,MD_TICK,TICK|S";
+      else out << std::string("\x01\x30\x01\x01", 4);
+    }
+
+    cfg.append = true;
+    {
+      EventRecorder rec(path, fmt, cfg);
+      ASSERT_TRUE(rec.ok());
+      for (uint64_t i = 1001; i <= 1500; ++i) rec.on_event(ev(i));
+    }
+
+    uint64_t errors = 0;
+    const auto seqs = read_seqs(path, &errors);
+    EXPECT_EQ(errors, 0u) << to_string(fmt);
+    ASSERT_EQ(seqs.size(), 1500u) << to_string(fmt);
+    for (uint64_t i = 0; i < seqs.size(); ++i) ASSERT_EQ(seqs[i], i + 1) << to_string(fmt);
+
+    // the index covers both sessions
+    ReplayFilter f;
+    f.filter_by_symbol = true;
+    f.symbol = "S3";
+    uint64_t s3 = 0;
+    for (uint64_t i = 1; i <= 1500; ++i) s3 += std::get<Tick>(ev(i).p).symbol == "S3";
+    EventIndex idx;
+    ASSERT_TRUE(idx.load_for(path));
+    EXPECT_EQ(idx.blocks().front().offset, fmt == RecordFormat::Text ? 0u : kBinaryFileHeaderSize);
+    EXPECT_EQ(scan_events(path, f, [](Event&) { return true; }), s3) << to_string(fmt);
+    f.symbol = "NEW";
+    EXPECT_EQ(scan_events(path, f, [](Event&) { return true; }), 50u) << to_string(fmt);
+
+    std::remove(path.c_str());
+    std::remove(index_path_for(path).c_str());
+  }
+
+  // Binary: the torn record is the first event of a new symbol, so an
+  // intact SYMBOL record sits ahead of it. Both go, or the writer's symbol
+  // ids would run ahead of the rebuilt index's.
+  const std::string path = "logs/test_append_symbol.bin";
+  const std::string full = "logs/test_append_symbol_full.bin";
+  RecorderConfig cfg;
+  cfg.checksums = true;
+  auto sym_tick = [](uint64_t i, const char* sym) {
+    Event e = tick(i);
+    std::get<Tick>(e.p).symbol = sym;
+    return e;
+  };
+  auto file_bytes = [](const std::string& p) {
+    std::ifstream in(p, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  };
+  {
+    EventRecorder a(path, RecordFormat::Binary, cfg);
+    EventRecorder b(full, RecordFormat::Binary, cfg);
+    for (auto* rec : {&a, &b}) {
+      rec->on_event(sym_tick(1, "A"));
+      rec->on_event(sym_tick(2, "B"));
+    }
+    b.on_event(sym_tick(3, "X"));
+  }
+  {
+    // the same bytes as `full` up to the middle of X's EVENT record
+    const std::string head = file_bytes(path);
+    const std::string tail = file_bytes(full);
+    ASSERT_EQ(tail.compare(0, head.size(), head), 0);
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    out << tail.substr(head.size(), tail.size() - head.size() - 3);
+  }
+  cfg.append = true;
+  {
+    EventRecorder rec(path, RecordFormat::Binary, cfg);
+    ASSERT_TRUE(rec.ok());
+    for (uint64_t i = 3; i <= 9; ++i) rec.on_event(sym_tick(i, "Y"));
+    for (uint64_t i = 10; i <= 12; ++i) rec.on_event(sym_tick(i, "X"));
+  }
+  // per symbol, by a full scan and through the index
+  auto count = [&](const ReplayFilter& f, const std::string& sym) {
+    uint64_t n = 0;
+    scan_events(path, f, [&](Event& e) {
+      n += std::get<Tick>(e.p).symbol == sym;
+      return true;
+    });
+    return n;
+  };
+  ReplayFilter all, by_time, by_symbol;
+  by_time.filter_by_time = true;
+  by_time.ts_min = 1;
+  by_symbol.filter_by_symbol = true;
+  for (auto [sym, n] : {std::pair<const char*, uint64_t>{"A", 1}, {"B", 1}, {"Y", 7}, {"X", 3}}) {
+    EXPECT_EQ(count(all, sym), n) << sym;
+    EXPECT_EQ(count(by_time, sym), n) << sym;
+    by_symbol.symbol = sym;
+    EXPECT_EQ(count(by_symbol, sym), n) << sym;
+  }
+  for (const auto& p : {path, full}) {
+    std::remove(p.c_str());
+    std::remove(index_path_for(p).c_str());
+  }
+}
+
+TEST(Recorder, ChecksumsCatchDamagedRecords) {
+  const std::string path = "logs/test_crc.bin";
+  RecorderConfig cfg;
+  cfg.checksums = true;
+  {
+    EventRecorder rec(path, RecordFormat::Binary, cfg);
+    for (uint64_t i = 1; i <= 100; ++i) rec.on_event(tick(i));
+  }
+  {
+    // flip one bit in the middle of the file: still a well-formed record
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekg(0, std::ios::end);
+    const auto mid = f.tellg() / 2;
+    f.seekg(mid);
+    char c = 0;
+    f.get(c);
+    f.seekp(mid);
+    f.put(static_cast<char>(c ^ 0x10));
+  }
+
+  uint64_t errors = 0;
+  const auto before = read_seqs(path, &errors);
+  EXPECT_EQ(errors, 1u);
+  EXPECT_LT(before.size(), 100u);
+
+  cfg.append = true;
+  {
+    EventRecorder rec(path, RecordFormat::Binary, cfg);
+    rec.on_event(tick(1000));
+  }
+  const auto after = read_seqs(path, &errors);
+  EXPECT_EQ(errors, 0u);
+  ASSERT_EQ(after.size(), before.size() + 1);
+  EXPECT_EQ(after.back(), 1000u);
+
+  // a log of another format is refused rather than overwritten
+  EventRecorder text(path, RecordFormat::Text, cfg);
+  EXPECT_FALSE(text.ok());
+
+  std::remove(path.c_str());
+  std::remove(index_path_for(path).c_str());
+}
+
+TEST(Recorder, GroupCommitHandsOffWithoutExplicitFlush) {
+  const std::string path = "logs/test_group_commit.bin";
+  RecorderConfig cfg;
+  cfg.flush_bytes = 1u << 30;
+  cfg.flush_interval = std::chrono::milliseconds(60'000);
+  cfg.flush_events = 100;
+  cfg.fsync = FsyncPolicy::EveryFlush;
+
+  EventRecorder rec(path, RecordFormat::Binary, cfg);
+  for (uint64_t i = 1; i <= 250; ++i) rec.on_event(tick(i));
+  // groups of 100 reach the file on their own; the last 50 wait for more
+  for (int spin = 0; spin < 2000 && read_seqs(path).size() < 200; ++spin) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_GE(read_seqs(path).size(), 200u);
+  rec.close();
+  EXPECT_EQ(read_seqs(path).size(), 250u);
+  std::remove(path.c_str());
+  std::remove(index_path_for(path).c_str());
+}
@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../engine/bus/bus.hpp"
+#include "../engine/common/event_index.hpp"
+#include "../engine/gen/synthetic_feed.hpp"
+#include "../engine/record/log_convert.hpp"
+#include "../engine/record/recorder.hpp"
+#include "../engine/replay/event_reader.hpp"
+#include "../engine/replay/replay.hpp"
+
+using namespace md;
+
+static void write_ticks(const std::string& path, uint64_t n, uint64_t step_ns) {
+  std::remove(path.c_str());
+  EventRecorder rec(path, RecordFormat::Binary);
+  for (uint64_t i = 1; i <= n; ++i) {
+    Event e;
+    e.h = {i, Topic::MD_TICK, 1'000'000'000 + i * step_ns};
+    e.p = Tick{"NIFTY", 22500.0 + static_cast<double>(i), static_cast<uint32_t>(i)};
+    rec.on_event(e);
+  }
+  rec.close();
+}
+
+TEST(Replay, TimedReplayDoesNotDrift) {
+  // 2000 events 50 us apart: 100 ms of recording. Sleeping per delta
+  // would overshoot on almost every event and run far longer.
+  const std::string path = "logs/test_replay_pacing.bin";
+  write_ticks(path, 2000, 50'000);
+
+  EventBus bus(1 << 12, 1 << 12);
+  EventReplay replay(path);
+  const auto t0 = std::chrono::steady_clock::now();
+  replay.replay_speed(bus, 1.0);
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - t0).count();
+  bus.stop();
+
+  const auto& st = replay.pacing_stats();
+  EXPECT_EQ(st.events, 2000u);
+  EXPECT_GE(ms, 99);
+  // the run ends within the last event's lag of its schedule, however
+  // loaded the machine: lag does not accumulate across events
+  EXPECT_LT(ms, 100 + static_cast<int64_t>(st.max_lag_ns / 1'000'000) + 500);
+  EXPECT_LE(st.p99_lag_ns, st.max_lag_ns);
+
+  // max_events stops the replay and the parse-ahead thread
+  replay.set_max_events(10);
+  EventBus bus2(1 << 12, 1 << 12);
+  replay.replay_speed(bus2, 4.0);
+  bus2.stop();
+  EXPECT_EQ(replay.pacing_stats().events, 10u);
+
+  std::remove(path.c_str());
+  std::remove(index_path_for(path).c_str());
+}
+
+TEST(Replay, RateAndBurstModesIgnoreRecordedTime) {
+  // Recorded 1 ms apart (2 s of data); replayed far faster than that.
+  const std::string path = "logs/test_replay_rate.bin";
+  write_ticks(path, 2000, 1'000'000);
+  EventReplay replay(path);
+  auto elapsed_ms = [](auto t0) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+  };
+
+  // 2000 events at 20k/s: 100 ms
+  ReplayRateConfig rate;
+  rate.events_per_sec = 20'000;
+  {
+    EventBus bus(1 << 12, 1 << 12);
+    const auto t0 = std::chrono::steady_clock::now();
+    replay.replay_rate(bus, rate);
+    const auto ms = elapsed_ms(t0);
+    bus.stop();
+    const auto& st = replay.pacing_stats();
+    EXPECT_EQ(st.events, 2000u);
+    EXPECT_GE(ms, 99);
+    EXPECT_LT(ms, 100 + static_cast<int64_t>(st.max_lag_ns / 1'000'000) + 500);
+  }
+
+  // bursts of 500 every 30 ms: the fourth burst starts at 90 ms, and each
+  // burst's events share one deadline
+  ReplayRateConfig burst;
+  burst.burst_events = 500;
+  burst.burst_interval_ns = 30'000'000;
+  burst.jitter_ns = 5'000;
+  {
+    EventBus bus(1 << 12, 1 << 12);
+    std::mutex mu;
+    std::vector<uint64_t> ts;  // as published, by recorded seq (qty)
+    ts.resize(2001);
+    std::atomic<std::size_t> seen{0};
+    bus.subscribe(Topic::MD_TICK, [&](const Event& e) {
+      const auto* t = std::get_if<Tick>(&e.p);
+      if (!t) return;
+      std::lock_guard<std::mutex> lk(mu);
+      ts[t->qty] = e.h.ts_ns;
+      ++seen;
+    });
+    const auto t0 = std::chrono::steady_clock::now();
+    replay.replay_rate(bus, burst);
+    const auto ms = elapsed_ms(t0);
+    for (int i = 0; i < 500 && seen < 2000; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    bus.stop();
+    const auto& st = replay.pacing_stats();
+    EXPECT_GE(ms, 89);
+    EXPECT_LT(ms, 90 + static_cast<int64_t>(st.max_lag_ns / 1'000'000) + 500);
+
+    // timestamps moved by at most the jitter, and not all by the same amount
+    ASSERT_EQ(seen.load(), 2000u);
+    std::size_t moved = 0;
+    for (uint64_t i = 1; i <= 2000; ++i) {
+      const uint64_t rec = 1'000'000'000 + i * 1'000'000;
+      const uint64_t d = ts[i] > rec ? ts[i] - rec : rec - ts[i];
+      EXPECT_LE(d, burst.jitter_ns);
+      moved += d != 0;
+    }
+    EXPECT_GT(moved, 1900u);
+  }
+
+  std::remove(path.c_str());
+  std::remove(index_path_for(path).c_str());
+}
+
+TEST(Replay, SymbolSetFilterSkipsDecodeInEveryFormat) {
+  SyntheticConfig gen;
+  gen.num_symbols = 500;
+  gen.total_events = 30'000;
+  const std::string text = "logs/test_replay_sets.txt";
+  const std::string bin = "logs/test_replay_sets.bin";
+  const std::string col = "logs/test_replay_sets.mdcc";
+  SyntheticFeed(gen).write_to_file(text, RecordFormat::Text);
+  ASSERT_TRUE(convert_log(text, bin, RecordFormat::Binary));
+  ASSERT_TRUE(convert_log(text, col, RecordFormat::Columnar));
+
+  ReplayFilter f;
+  for (int i = 0; i < 500; i += 25) f.add_symbol(fmt::format("SYM{:06}", i));
+  f.add_topic(Topic::MD_TICK);
+  f.add_topic(Topic::BAR_1S);
+  f.filter_by_time = true;
+  f.ts_min = gen.start_ts_ns + 200'000'000;
+
+  // reference: decode everything, then filter
+  uint64_t want = 0;
+  {
+    EventFileReader r(text);
+    Event e;
+    while (r.next(e)) want += event_matches(f, e);
+  }
+  ASSERT_GT(want, 500u);
+
+  for (const auto& path : {text, bin, col}) {
+    EXPECT_EQ(scan_events(path, f, [](Event&) { return true; }), want) << path;
+
+    EventFileReader r(path);
+    r.set_prefilter(prefilter_for(f));
+    Event e;
+    uint64_t n = 0;
+    while (r.next(e)) {
+      EXPECT_TRUE(event_matches(f, e)) << path;
+      ++n;
+    }
+    EXPECT_EQ(n, want) << path;
+    EXPECT_EQ(r.filtered(), gen.total_events - want) << path;
+  }
+
+  // a topic mask without ticks matches nothing in a tick log
+  ReplayFilter bars_only;
+  bars_only.add_topic(Topic::BAR_1M);
+  EXPECT_EQ(scan_events(bin, bars_only, [](Event&) { return true; }), 0u);
+
+  for (const auto& p : {text, bin, col}) {
+    std::remove(p.c_str());
+    std::remove(index_path_for(p).c_str());
+  }
+}
+
+TEST(Replay, PauseCheckpointAndResume) {
+  const std::string path = "logs/test_replay_resume.bin";
+  write_ticks(path, 5000, 1'000);
+
+  EventReplay replay(path);
+  std::mutex mu;
+  std::vector<uint32_t> seen;  // qty == recorded seq
+  auto delivered = [&](std::size_t n) {
+    for (int i = 0; i < 500; ++i) {
+      {
+        std::lock_guard<std::mutex> lk(mu);
+        if (seen.size() >= n) return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return false;
+  };
+  // runs a replay until `total` events have been seen (pausing at pause_at)
+  auto run = [&](uint32_t pause_at, std::size_t total) {
+    // small queues: the replay cannot run far ahead of the subscriber
+    EventBus bus(16, 16);
+    bus.subscribe(Topic::MD_TICK, [&](const Event& e) {
+      const auto* t = std::get_if<Tick>(&e.p);
+      if (!t) return;
+      std::lock_guard<std::mutex> lk(mu);
+      seen.push_back(t->qty);
+      if (t->qty == pause_at) replay.pause();
+    });
+    replay.replay_fast(bus);
+    EXPECT_TRUE(delivered(total ? total : replay.checkpoint().seq));
+    bus.stop();
+  };
+
+  run(1200, 0);
+  ASSERT_TRUE(replay.paused());
+  const ReplayCheckpoint cp = replay.checkpoint();
+  ASSERT_TRUE(cp.valid);
+  EXPECT_GE(cp.seq, 1200u);
+  EXPECT_LT(cp.seq, 5000u);
+
+  replay.resume_from(cp);
+  run(0, 5000);
+  EXPECT_FALSE(replay.paused());
+  EXPECT_EQ(replay.checkpoint().seq, 5000u);
+  ASSERT_EQ(seen.size(), 5000u);
+  for (uint32_t i = 0; i < 5000; ++i) ASSERT_EQ(seen[i], i + 1);
+
+  // starting at a timestamp: event 4001 is at 1e9 + 4'001'000
+  replay.seek_to_ts(1'000'000'000 + 4'000'500);
+  seen.clear();
+  run(0, 1000);
+  ASSERT_EQ(seen.size(), 1000u);
+  EXPECT_EQ(seen.front(), 4001u);
+
+  // a pause requested after a replay has finished does not stop the next
+  replay.pause();
+  replay.resume_from(cp);
+  seen.clear();
+  run(0, 5000 - cp.seq);
+  EXPECT_FALSE(replay.paused());
+  EXPECT_EQ(replay.checkpoint().seq, 5000u);
+  ASSERT_EQ(seen.size(), 5000 - cp.seq);
+  EXPECT_EQ(seen.front(), cp.seq + 1);
+
+  std::remove(path.c_str());
+  std::remove(index_path_for(path).c_str());
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../engine/bus/bus.hpp"
+#include "../engine/gen/synthetic_feed.hpp"
+
+using namespace md;
+
+TEST(SyntheticFeed, SameSeedSameTicks) {
+  SyntheticConfig cfg;
+  cfg.num_symbols = 50;
+  cfg.zipf_s = 1.1;
+  cfg.arrival = ArrivalProcess::Bursty;
+  cfg.total_events = 5000;
+  cfg.seed = 7;
+
+  SyntheticFeed a(cfg), b(cfg);
+  Event x, y;
+  uint64_t last_ts = 0;
+  std::set<std::string> universe(a.symbols().begin(), a.symbols().end());
+  for (uint64_t i = 0; i < cfg.total_events; ++i) {
+    ASSERT_TRUE(a.next(x));
+    ASSERT_TRUE(b.next(y));
+    EXPECT_EQ(x.h.seq, i);
+    EXPECT_EQ(x.h.topic, Topic::MD_TICK);
+    EXPECT_EQ(x.h.ts_ns, y.h.ts_ns);
+    EXPECT_GE(x.h.ts_ns, last_ts);
+    last_ts = x.h.ts_ns;
+
+    const auto& t = std::get<Tick>(x.p);
+    const auto& u = std::get<Tick>(y.p);
+    EXPECT_EQ(t.symbol, u.symbol);
+    EXPECT_EQ(t.pq, u.pq);
+    EXPECT_EQ(t.qty, u.qty);
+    EXPECT_EQ(universe.count(t.symbol), 1u);
+    // on the 0.01 grid
+    EXPECT_NEAR(t.pq * 100.0, std::round(t.pq * 100.0), 1e-6);
+    EXPECT_GE(t.qty, cfg.min_qty);
+    EXPECT_LE(t.qty, cfg.max_qty);
+  }
+  EXPECT_FALSE(a.next(x));
+  EXPECT_EQ(a.produced(), cfg.total_events);
+}
+
+TEST(SyntheticFeed, PublishLiveKeepsSyntheticTimestamps) {
+  // 500 events at 50k/s: about 10 ms of wall time
+  SyntheticConfig cfg;
+  cfg.total_events = 500;
+  cfg.rate_eps = 50'000.0;
+
+  EventBus bus(1 << 10, 1 << 10);
+  std::mutex mu;
+  std::vector<uint64_t> ts;
+  bus.subscribe(Topic::MD_TICK, [&](const Event& e) {
+    if (!std::holds_alternative<Tick>(e.p)) return;
+    std::lock_guard<std::mutex> lk(mu);
+    ts.push_back(e.h.ts_ns);
+  });
+
+  SyntheticFeed feed(cfg);
+  const uint64_t published = feed.publish_live(bus);
+  auto delivered = [&] {
+    std::lock_guard<std::mutex> lk(mu);
+    return ts.size();
+  };
+  for (int i = 0; i < 500 && delivered() < published; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  bus.stop();
+
+  EXPECT_EQ(published, cfg.total_events);
+  ASSERT_EQ(ts.size(), published);
+  // the timestamps the generator drew, not the publish times
+  SyntheticFeed again(cfg);
+  Event e;
+  for (uint64_t i = 0; i < published; ++i) {
+    ASSERT_TRUE(again.next(e));
+    EXPECT_EQ(ts[i], e.h.ts_ns) << i;
+  }
+}